@@ -1,4 +1,5 @@
 #include <bits/stdc++.h>
+#include "../Instrumentation/Metrics.h"
 #define ll long long int 
 using namespace std;
 
@@ -177,6 +178,604 @@ class PremiumWheatBurger : public Burger{
 };
 
 
+/**
+ * @brief Per-type, per-thread free list of burger objects
+ * 
+ * Creating a burger used to be a new/delete pair for a tiny object. The pool
+ * keeps released blocks of sizeof(T) on a thread local free list and hands
+ * them back on the next acquire(), so steady-state creation never reaches
+ * malloc.
+ * 
+ * A burger is often released on another thread than the one that acquired
+ * it (the Kitchen prepares orders on its workers). Such a block goes onto a
+ * lock-free overflow stack shared by every thread; an acquire() that finds
+ * its own list empty takes the whole stack in one exchange, so the creating
+ * thread gets its blocks back instead of allocating forever.
+ */
+template<class T>
+class BurgerPool {
+    public:
+    /**
+     * @brief Constructs a T in a recycled block, or a fresh one if the lists are empty
+     */
+    static T* acquire(){
+        FreeList& list = local();
+        if(list.head == nullptr){
+            // Taking the whole stack at once cannot suffer from ABA
+            for(Node* node = overflow().exchange(nullptr, memory_order_acquire); node != nullptr; ){
+                Node* next = node->next;
+                node->next = list.head;
+                list.head = node;
+                list.count++;
+                node = next;
+            }
+        }
+        void* mem;
+        if(list.head != nullptr){
+            mem = list.head;
+            list.head = list.head->next;
+            list.count--;
+        }else{
+            mem = ::operator new(sizeof(T));
+            fresh().fetch_add(1, memory_order_relaxed);
+        }
+        return new(mem) T();
+    }
+    
+    /**
+     * @brief Destroys the burger and keeps its block for the next acquire()
+     * 
+     * @param home Free list of the thread that acquired it, as returned by
+     *        home(); only compared, never dereferenced
+     */
+    static void release(Burger* burger, const void* home){
+        T* object = static_cast<T*>(burger);
+        object->~T();
+        Node* node = reinterpret_cast<Node*>(object);
+        FreeList& list = local();
+        if(home != &list){
+            Node* head = overflow().load(memory_order_relaxed);
+            do{
+                node->next = head;
+            }while(!overflow().compare_exchange_weak(head, node, memory_order_release, memory_order_relaxed));
+            return;
+        }
+        if(list.count >= MAX_CACHED){
+            ::operator delete(object);
+            return;
+        }
+        node->next = list.head;
+        list.head = node;
+        list.count++;
+    }
+    
+    /**
+     * @brief Identifies this thread's free list, for release()
+     */
+    static const void* home(){
+        return &local();
+    }
+    
+    /**
+     * @brief Blocks taken from the heap so far; flat once the pool is warm
+     */
+    static uint64_t allocations(){
+        return fresh().load(memory_order_relaxed);
+    }
+    
+    private:
+    static const size_t MAX_CACHED = 4096;
+    
+    struct Node {
+        Node* next;
+    };
+    
+    struct FreeList {
+        Node* head = nullptr;
+        size_t count = 0;
+        
+        ~FreeList(){
+            while(head != nullptr){
+                Node* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    };
+    
+    static FreeList& local(){
+        thread_local FreeList list;
+        return list;
+    }
+    
+    // Never destroyed, so a burger released during static destruction still
+    // has somewhere to go
+    static atomic<Node*>& overflow(){
+        static atomic<Node*>* stack = new atomic<Node*>(nullptr);
+        return *stack;
+    }
+    
+    static atomic<uint64_t>& fresh(){
+        static atomic<uint64_t> count{0};
+        return count;
+    }
+};
+
+/**
+ * @brief Deleter that sends a burger back to the pool it came from
+ */
+struct BurgerRecycler {
+    void (*recycle)(Burger*, const void*) = nullptr;
+    const void* home = nullptr;         // free list of the acquiring thread
+    
+    void operator()(Burger* burger) const {
+        recycle(burger, home);
+    }
+};
+
+/**
+ * @brief Owning handle to a pooled burger, recycles it when it goes out of scope
+ */
+typedef unique_ptr<Burger, BurgerRecycler> BurgerHandle;
+
+/**
+ * @brief Creates a pooled burger of type T
+ */
+template<class T>
+BurgerHandle makeBurger(){
+    return BurgerHandle(BurgerPool<T>::acquire(), BurgerRecycler{&BurgerPool<T>::release, BurgerPool<T>::home()});
+}
+
+/**
+ * @brief Reason a burger could not be created
+ */
+enum class BurgerError {
+    None,
+    InvalidType
+};
+
+/**
+ * @brief Returns a human readable message for a BurgerError
+ */
+const char* describe(BurgerError error){
+    switch(error){
+        case BurgerError::None: return "OK";
+        case BurgerError::InvalidType: return "Invalid Burger Type, Please Enter Valid Input";
+    }
+    return "Unknown Error";
+}
+
+/**
+ * @brief Result of a createBurger() call
+ * 
+ * Either holds the created burger, or a null burger and the reason it
+ * could not be created. The factory no longer prints errors itself;
+ * the caller decides how to report them. The burger is returned to its
+ * pool when the handle goes out of scope, so callers never delete it.
+ */
+struct BurgerResult {
+    BurgerHandle burger;
+    BurgerError error;
+    
+    bool ok() const {
+        return error == BurgerError::None;
+    }
+};
+
+/**
+ * @brief A batch of burgers stored contiguously and grouped by concrete type
+ * 
+ * createBatch() counts how many of each type were ordered, allocates one
+ * block and constructs every burger of the same type next to each other.
+ * prepareAll() then walks one homogeneous run at a time, so the virtual
+ * prepration() call keeps hitting the same target and stays predictable.
+ */
+class BurgerBatch {
+    public:
+    /**
+     * @brief Consecutive burgers of one concrete type
+     */
+    struct Run {
+        Burger* first;
+        size_t count;
+        size_t stride;
+        
+        Burger* at(size_t i) const {
+            return reinterpret_cast<Burger*>(reinterpret_cast<char*>(first) + i * stride);
+        }
+    };
+    
+    BurgerBatch() = default;
+    BurgerBatch(const BurgerBatch&) = delete;
+    BurgerBatch& operator=(const BurgerBatch&) = delete;
+    
+    BurgerBatch(BurgerBatch&& other) noexcept {
+        *this = move(other);
+    }
+    
+    BurgerBatch& operator=(BurgerBatch&& other) noexcept {
+        if(this != &other){
+            destroy();
+            storage = other.storage;
+            runList = move(other.runList);
+            orders = move(other.orders);
+            invalid = other.invalid;
+            other.storage = nullptr;
+            other.runList.clear();
+            other.orders.clear();
+            other.invalid = 0;
+        }
+        return *this;
+    }
+    
+    ~BurgerBatch(){
+        destroy();
+    }
+    
+    /**
+     * @brief Calls prepration() on every burger, one concrete type at a time
+     */
+    void prepareAll(){
+        for(const Run& run : runList){
+            for(size_t i = 0; i < run.count; i++){
+                run.at(i)->prepration();
+            }
+        }
+    }
+    
+    const vector<Run>& runs() const {
+        return runList;
+    }
+    
+    /**
+     * @brief Burger created for the i-th key, nullptr if that key was invalid
+     */
+    Burger* operator[](size_t i) const {
+        return orders[i];
+    }
+    
+    size_t size() const {
+        return orders.size() - invalid;
+    }
+    
+    size_t rejected() const {
+        return invalid;
+    }
+    
+    private:
+    friend class BurgerRegistry;
+    
+    static const size_t ALIGNMENT = 64;
+    
+    void* storage = nullptr;
+    vector<Run> runList;
+    vector<Burger*> orders;
+    size_t invalid = 0;
+    
+    void destroy(){
+        for(const Run& run : runList){
+            for(size_t i = 0; i < run.count; i++){
+                run.at(i)->~Burger();
+            }
+        }
+        runList.clear();
+        if(storage != nullptr){
+            ::operator delete(storage, align_val_t(ALIGNMENT));
+            storage = nullptr;
+        }
+    }
+};
+
+/**
+ * @brief Two-level registry of burger constructors keyed by (family, type)
+ * 
+ * Every product family (SinghBurger, KingBurger, or any family plugged in at
+ * runtime) registers its burgers here instead of keeping its own if/else
+ * ladder. Both levels live in one flat open-addressing table whose hash
+ * covers family and type together, so a lookup resolves ("KingBurger",
+ * "premium") with a single probe sequence.
+ * 
+ * Readers never lock and reach the table through one atomic pointer. add()
+ * runs under a writer lock and fills a new key into the current table in
+ * place, publishing its slot with a release store, so a reader sees either
+ * the whole key or an empty slot. The table is only copied when it doubles;
+ * the old one is kept until the registry is destroyed, so a reader still
+ * probing it stays valid, and the old tables add up to less than the
+ * current one.
+ */
+class BurgerRegistry {
+    public:
+    typedef BurgerHandle (*Constructor)();
+    typedef Burger* (*Placer)(void*);
+    
+    BurgerRegistry(){
+        tables.emplace_back(new Table(16));
+        current.store(tables.back().get(), memory_order_release);
+    }
+    
+    BurgerRegistry(const BurgerRegistry&) = delete;
+    BurgerRegistry& operator=(const BurgerRegistry&) = delete;
+    
+    /**
+     * @brief Process wide registry with the built-in families registered
+     * 
+     * - SinghBurger: "basic" -> BasicBurger, "standard" -> StandardBurger,
+     *   "premium" -> PremiumBurger
+     * - KingBurger: "basic" -> BasicWheatBurger, "standard" -> StandarWheatdBurger,
+     *   "premium" -> PremiumWheatBurger
+     */
+    static BurgerRegistry& global(){
+        // Never destroyed, so factories owned by other statics stay usable at exit
+        static BurgerRegistry* registry = []{
+            BurgerRegistry* r = new BurgerRegistry();
+            r->add<BasicBurger>("SinghBurger", "basic");
+            r->add<StandardBurger>("SinghBurger", "standard");
+            r->add<PremiumBurger>("SinghBurger", "premium");
+            r->add<BasicWheatBurger>("KingBurger", "basic");
+            r->add<StandarWheatdBurger>("KingBurger", "standard");
+            r->add<PremiumWheatBurger>("KingBurger", "premium");
+            return r;
+        }();
+        return *registry;
+    }
+    
+    /**
+     * @brief Registers burger type T as (family, type); safe while others read
+     * 
+     * Registering an existing (family, type) replaces its constructor.
+     * 
+     * @return false if MAX_GROUPS distinct concrete types are already
+     *         registered and T is not one of them
+     */
+    template<class T>
+    bool add(string_view family, string_view type){
+        return insert(family, type, &makeBurger<T>, &placeBurger<T>, sizeof(T), alignof(T));
+    }
+    
+    /**
+     * @brief Creates the burger registered as (family, type)
+     * 
+     * @return BurgerResult with the new burger, or BurgerError::InvalidType
+     *         if the family does not offer that type
+     */
+    BurgerResult create(string_view family, string_view type) const {
+        const Table* table = current.load(memory_order_acquire);
+        const Slot* slot = find(*table, family, type);
+        if(slot == nullptr){
+            return {nullptr, BurgerError::InvalidType};
+        }
+        return {slot->make.load(memory_order_acquire)(), BurgerError::None};
+    }
+    
+    /**
+     * @brief Creates one burger per key of the family in a single contiguous block
+     * 
+     * @param family Product family every key belongs to
+     * @param keys Type keys, one per ordered burger
+     * @param count Number of keys
+     * @return BurgerBatch with the burgers grouped by concrete type; invalid
+     *         keys are counted in rejected() and map to nullptr
+     */
+    BurgerBatch createBatch(string_view family, const string_view* keys, size_t count) const {
+        const Table& table = *current.load(memory_order_acquire);
+        BurgerBatch batch;
+        vector<uint32_t> resolved(count, UINT32_MAX);
+        for(size_t i = 0; i < count; i++){
+            const Slot* slot = find(table, family, keys[i]);
+            if(slot == nullptr){
+                batch.invalid++;
+            }else{
+                resolved[i] = slot->group.load(memory_order_acquire);
+            }
+        }
+        // Loaded after the slots, so it covers every group they refer to
+        size_t groupCount = groupsPublished.load(memory_order_acquire);
+        vector<size_t> perGroup(groupCount, 0);
+        for(size_t i = 0; i < count; i++){
+            if(resolved[i] != UINT32_MAX) perGroup[resolved[i]]++;
+        }
+        
+        // Lay the runs out back to back, each starting on its type's alignment
+        vector<size_t> offset(groupCount, 0);
+        size_t bytes = 0;
+        for(size_t g = 0; g < groupCount; g++){
+            if(perGroup[g] == 0) continue;
+            bytes = (bytes + groups[g].align - 1) / groups[g].align * groups[g].align;
+            offset[g] = bytes;
+            bytes += perGroup[g] * groups[g].size;
+        }
+        if(bytes > 0){
+            batch.storage = ::operator new(bytes, align_val_t(BurgerBatch::ALIGNMENT));
+        }
+        
+        vector<size_t> runOf(groupCount, 0);
+        for(size_t g = 0; g < groupCount; g++){
+            if(perGroup[g] == 0) continue;
+            runOf[g] = batch.runList.size();
+            batch.runList.push_back({nullptr, 0, groups[g].size});
+        }
+        batch.orders.resize(count, nullptr);
+        for(size_t i = 0; i < count; i++){
+            if(resolved[i] == UINT32_MAX) continue;
+            uint32_t g = resolved[i];
+            BurgerBatch::Run& run = batch.runList[runOf[g]];
+            char* mem = static_cast<char*>(batch.storage) + offset[g] + run.count * run.stride;
+            Burger* burger = groups[g].place(mem);
+            if(run.count == 0){
+                run.first = burger;
+            }
+            run.count++;
+            batch.orders[i] = burger;
+        }
+        return batch;
+    }
+    
+    bool contains(string_view family, string_view type) const {
+        return find(*current.load(memory_order_acquire), family, type) != nullptr;
+    }
+    
+    size_t size() const {
+        return used.load(memory_order_acquire);
+    }
+    
+    /**
+     * @brief Most distinct concrete burger types one registry can hold
+     */
+    static const uint32_t MAX_GROUPS = 256;
+    
+    private:
+    /**
+     * @brief One (family, type) key
+     * 
+     * The writer fills in the key first and publishes the slot with a
+     * release store of make; a null make is an empty slot. Replacing an
+     * existing key only swaps make and group.
+     */
+    struct Slot {
+        string_view family;
+        string_view type;
+        uint64_t hash = 0;
+        atomic<Constructor> make{nullptr};
+        atomic<uint32_t> group{0};
+    };
+    
+    /**
+     * @brief One entry per concrete type, shared by every key that maps to it
+     */
+    struct Group {
+        Placer place;
+        size_t size;
+        size_t align;
+    };
+    
+    struct Table {
+        size_t mask;
+        unique_ptr<Slot[]> slots;
+        
+        explicit Table(size_t capacity) : mask(capacity - 1), slots(new Slot[capacity]) {}
+    };
+    
+    atomic<Table*> current;
+    // Every published table, oldest first. Readers never lock, so an old
+    // table may still be probed and lives as long as the registry. New keys
+    // go into the current table in place and it is only copied when it
+    // doubles, so the old tables add up to less than the current one.
+    vector<unique_ptr<Table>> tables;
+    Group groups[MAX_GROUPS];
+    atomic<uint32_t> groupsPublished{0};
+    atomic<size_t> used{0};
+    deque<string> names;                // owns the key bytes, deque keeps them in place
+    mutex writeLock;
+    
+    template<class T>
+    static Burger* placeBurger(void* mem){
+        return new(mem) T();
+    }
+    
+    /**
+     * @brief FNV-1a over family, a separator byte, then type
+     */
+    static uint64_t hash(string_view family, string_view type){
+        uint64_t h = 1469598103934665603ULL;
+        for(char c : family){
+            h ^= (unsigned char)c;
+            h *= 1099511628211ULL;
+        }
+        h ^= 0xff;
+        h *= 1099511628211ULL;
+        for(char c : type){
+            h ^= (unsigned char)c;
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+    
+    static bool matches(const Slot& slot, uint64_t h, string_view family, string_view type){
+        return slot.hash == h && slot.type == type && slot.family == family;
+    }
+    
+    static const Slot* find(const Table& table, string_view family, string_view type){
+        uint64_t h = hash(family, type);
+        for(size_t i = h & table.mask; ; i = (i + 1) & table.mask){
+            const Slot& slot = table.slots[i];
+            if(slot.make.load(memory_order_acquire) == nullptr){
+                return nullptr;
+            }
+            if(matches(slot, h, family, type)){
+                return &slot;
+            }
+        }
+    }
+    
+    /**
+     * @brief Writer side: the slot holding the key, or the empty slot it goes in
+     */
+    static Slot& probe(Table& table, uint64_t h, string_view family, string_view type){
+        for(size_t i = h & table.mask; ; i = (i + 1) & table.mask){
+            Slot& slot = table.slots[i];
+            if(slot.make.load(memory_order_relaxed) == nullptr || matches(slot, h, family, type)){
+                return slot;
+            }
+        }
+    }
+    
+    static void publish(Slot& slot, string_view family, string_view type, uint64_t h, Constructor make, uint32_t group){
+        slot.family = family;
+        slot.type = type;
+        slot.hash = h;
+        slot.group.store(group, memory_order_release);
+        slot.make.store(make, memory_order_release);
+    }
+    
+    bool insert(string_view family, string_view type, Constructor make, Placer placer, size_t size, size_t align){
+        lock_guard<mutex> guard(writeLock);
+        uint32_t groupCount = groupsPublished.load(memory_order_relaxed);
+        uint32_t group = 0;
+        while(group < groupCount && groups[group].place != placer){
+            group++;
+        }
+        if(group == groupCount){
+            if(groupCount == MAX_GROUPS){
+                return false;
+            }
+            groups[group] = {placer, size, align};
+            groupsPublished.store(groupCount + 1, memory_order_release);
+        }
+        
+        uint64_t h = hash(family, type);
+        Table* table = current.load(memory_order_relaxed);
+        Slot* slot = &probe(*table, h, family, type);
+        if(slot->make.load(memory_order_relaxed) != nullptr){
+            slot->group.store(group, memory_order_release);
+            slot->make.store(make, memory_order_release);
+            return true;
+        }
+        
+        // Keep the load factor at or below one half so probe runs stay short
+        size_t count = used.load(memory_order_relaxed);
+        if((count + 1) * 2 > table->mask + 1){
+            unique_ptr<Table> bigger(new Table((table->mask + 1) * 2));
+            for(size_t i = 0; i <= table->mask; i++){
+                const Slot& old = table->slots[i];
+                Constructor oldMake = old.make.load(memory_order_relaxed);
+                if(oldMake != nullptr){
+                    publish(probe(*bigger, old.hash, old.family, old.type), old.family, old.type, old.hash, oldMake, old.group.load(memory_order_relaxed));
+                }
+            }
+            table = bigger.get();
+            tables.push_back(move(bigger));
+            current.store(table, memory_order_release);
+            slot = &probe(*table, h, family, type);
+        }
+        names.emplace_back(family);
+        string_view familyKey = names.back();
+        names.emplace_back(type);
+        publish(*slot, familyKey, names.back(), h, make, group);
+        used.store(count + 1, memory_order_release);
+        return true;
+    }
+};
+
 /**
  * @brief Abstract factory class for creating Burger objects
  * 
@@ -194,13 +793,27 @@ class BurgerFactory {
     /**
      * @brief Pure virtual factory method to create Burger objects
      * 
-     * @param type String representing the type of burger to create
-     * @return Burger* Pointer to the created burger object
+     * @param type Key of the burger type to create
+     * @return BurgerResult holding the created burger, or the reason it failed
      * 
      * This method must be implemented by concrete factory classes.
      * Each concrete factory will create its own family of products.
      */
-    virtual Burger* createBurger(string& type) = 0;
+    virtual BurgerResult createBurger(string_view type) = 0;
+    
+    /**
+     * @brief Pure virtual batch factory method
+     * 
+     * @param keys Type keys of the ordered burgers
+     * @param count Number of keys
+     * @return BurgerBatch with the products stored contiguously and grouped
+     *         by concrete type, so prepareAll() sweeps homogeneous runs
+     */
+    virtual BurgerBatch createBatch(const string_view* keys, size_t count) = 0;
+    
+    BurgerBatch createBatch(const vector<string_view>& keys){
+        return createBatch(keys.data(), keys.size());
+    }
     
     /**
      * @brief Virtual destructor for proper cleanup
@@ -213,91 +826,426 @@ class BurgerFactory {
 
 
 /**
- * @brief Concrete factory for creating regular burger variants
- * 
- * This is a Concrete Creator in the Factory Method pattern.
- * It implements the factory method to create regular burger products
- * (Basic, Standard, Premium) as part of the SinghBurger product family.
+ * @brief Concrete creator that serves one product family from a BurgerRegistry
  * 
- * Product Family: Regular Burgers
- * - BasicBurger: Basic regular burger
- * - StandardBurger: Standard regular burger  
- * - PremiumBurger: Premium regular burger
+ * This is the plugin point of the Factory Method pattern: a new family is
+ * added by registering its burgers in the registry, and a
+ * RegistryBurgerFactory for that family name creates them. No factory code
+ * has to change.
  */
-class SinghBurger : public BurgerFactory{
+class RegistryBurgerFactory : public BurgerFactory{
+    private:
+    string family;
+    BurgerRegistry* registry;
+    
     public:
+    RegistryBurgerFactory(string_view family, BurgerRegistry& registry = BurgerRegistry::global()){
+        this->family = string(family);
+        this->registry = &registry;
+    }
+    
     /**
-     * @brief Factory method implementation for regular burger creation
-     * 
-     * @param type String representing the type of regular burger to create
-     * @return Burger* Pointer to the created regular burger object, or nullptr if invalid type
+     * @brief Creates the family's burger registered under type
      * 
-     * This method creates regular burger variants:
-     * - "basic" -> creates BasicBurger
-     * - "standard" -> creates StandardBurger
-     * - "premium" -> creates PremiumBurger
-     * - any other value -> returns nullptr and prints error message
+     * @param type Key of the burger to create
+     * @return BurgerResult holding the created burger, or BurgerError::InvalidType
+     *         if this family does not offer the type
      */
-    Burger* createBurger(string& type){
-        if(type == "basic"){
-            return new BasicBurger();
-        }
-        else if(type == "standard"){
-            return new StandardBurger();
-        }
-        else if(type == "premium"){
-            return new PremiumBurger();
+    BurgerResult createBurger(string_view type) override{
+        METRIC_TIMER("factory_method_create_ns");
+        BurgerResult result = registry->create(family, type);
+        if(result.ok()){
+            METRIC_COUNT("factory_method_created_total", 1);
         }else{
-            cout<<"Invalid Burger Type, Please Enter Valid Input"<<endl;
-            return nullptr;
+            METRIC_COUNT("factory_method_rejected_total", 1);
         }
+        return result;
+    }
+    
+    using BurgerFactory::createBatch;
+    
+    BurgerBatch createBatch(const string_view* keys, size_t count) override{
+        METRIC_TIMER("factory_method_batch_ns");
+        METRIC_COUNT("factory_method_batch_orders_total", count);
+        return registry->createBatch(family, keys, count);
     }
     
+    const string& name() const {
+        return family;
+    }
+};
+
+/**
+ * @brief Concrete factory for creating regular burger variants
+ * 
+ * This is a Concrete Creator in the Factory Method pattern.
+ * It creates regular burger products (Basic, Standard, Premium) as part
+ * of the SinghBurger product family, as registered in the BurgerRegistry.
+ * 
+ * Product Family: Regular Burgers
+ * - "basic" -> BasicBurger: Basic regular burger
+ * - "standard" -> StandardBurger: Standard regular burger  
+ * - "premium" -> PremiumBurger: Premium regular burger
+ */
+class SinghBurger : public RegistryBurgerFactory{
+    public:
+    SinghBurger(BurgerRegistry& registry = BurgerRegistry::global()) : RegistryBurgerFactory("SinghBurger", registry){}
 };
 
 /**
  * @brief Concrete factory for creating wheat burger variants
  * 
  * This is a Concrete Creator in the Factory Method pattern.
- * It implements the factory method to create wheat burger products
- * (BasicWheat, StandardWheat, PremiumWheat) as part of the KingBurger product family.
+ * It creates wheat burger products (BasicWheat, StandardWheat, PremiumWheat)
+ * as part of the KingBurger product family, as registered in the BurgerRegistry.
  * 
  * Product Family: Wheat Burgers
- * - BasicWheatBurger: Basic wheat burger
- * - StandarWheatdBurger: Standard wheat burger
- * - PremiumWheatBurger: Premium wheat burger
+ * - "basic" -> BasicWheatBurger: Basic wheat burger
+ * - "standard" -> StandarWheatdBurger: Standard wheat burger
+ * - "premium" -> PremiumWheatBurger: Premium wheat burger
  */
-class KingBurger : public BurgerFactory{
+class KingBurger : public RegistryBurgerFactory{
+    public:
+    KingBurger(BurgerRegistry& registry = BurgerRegistry::global()) : RegistryBurgerFactory("KingBurger", registry){}
+};
+
+/**
+ * @brief Stream buffer that discards everything written to it
+ * 
+ * Used while benchmarking so the console output of prepration()
+ * does not dominate the timings.
+ */
+class NullBuffer : public streambuf {
+    protected:
+    int overflow(int c) override {
+        return c;
+    }
+    
+    streamsize xsputn(const char*, streamsize n) override {
+        return n;
+    }
+};
+
+/**
+ * @brief Runs create -> prepration() -> destroy in a loop and returns ops/sec
+ */
+template<class Body>
+double measureThroughput(size_t iterations, Body body){
+    auto start = chrono::steady_clock::now();
+    for(size_t i = 0; i < iterations; i++){
+        body(i);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return iterations / seconds;
+}
+
+/**
+ * @brief Compares the old new/delete path with pooled burgers
+ * 
+ * Three variants, all cycling through the three wheat burgers:
+ * - new/delete: what createBurger() used to do
+ * - pooled: BurgerPool directly, no menu lookup
+ * - factory: KingBurger::createBurger(), menu lookup plus pool
+ */
+void benchmarkPooling(size_t iterations){
+    NullBuffer sink;
+    streambuf* console = cout.rdbuf(&sink);
+    
+    double newDelete = measureThroughput(iterations, [](size_t i){
+        Burger* burger;
+        switch(i % 3){
+            case 0: burger = new BasicWheatBurger(); break;
+            case 1: burger = new StandarWheatdBurger(); break;
+            default: burger = new PremiumWheatBurger(); break;
+        }
+        burger->prepration();
+        delete burger;
+    });
+    
+    double pooled = measureThroughput(iterations, [](size_t i){
+        BurgerHandle burger;
+        switch(i % 3){
+            case 0: burger = makeBurger<BasicWheatBurger>(); break;
+            case 1: burger = makeBurger<StandarWheatdBurger>(); break;
+            default: burger = makeBurger<PremiumWheatBurger>(); break;
+        }
+        burger->prepration();
+    });
+    
+    KingBurger factory;
+    const string_view keys[] = {"basic", "standard", "premium"};
+    double viaFactory = measureThroughput(iterations, [&](size_t i){
+        BurgerResult result = factory.createBurger(keys[i % 3]);
+        result.burger->prepration();
+    });
+    
+    cout.rdbuf(console);
+    cout<<fixed<<setprecision(0);
+    cout<<"new/delete : "<<newDelete<<" ops/sec"<<endl;
+    cout<<"pooled     : "<<pooled<<" ops/sec ("<<setprecision(2)<<pooled / newDelete<<"x)"<<endl;
+    cout<<setprecision(0)<<"factory    : "<<viaFactory<<" ops/sec ("<<setprecision(2)<<viaFactory / newDelete<<"x)"<<endl;
+}
+
+/**
+ * @brief Bounded multi-producer multi-consumer queue
+ * 
+ * Classic ring of cells with a per-cell sequence number: producers and
+ * consumers each claim a position with one compare-and-swap and never
+ * block each other. tryPush() fails when the ring is full, tryPop() when
+ * it is empty, so callers decide how to back off.
+ */
+template<class T>
+class BoundedMpmcQueue {
+    public:
+    explicit BoundedMpmcQueue(size_t capacity){
+        size_t cap = 2;
+        while(cap < capacity) cap <<= 1;
+        cells.reset(new Cell[cap]);
+        mask = cap - 1;
+        for(size_t i = 0; i < cap; i++){
+            cells[i].seq.store(i, memory_order_relaxed);
+        }
+    }
+    
+    bool tryPush(T& value){
+        size_t pos = enqueuePos.load(memory_order_relaxed);
+        for(;;){
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.seq.load(memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if(diff == 0){
+                if(enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)){
+                    cell.value = move(value);
+                    cell.seq.store(pos + 1, memory_order_release);
+                    return true;
+                }
+            }else if(diff < 0){
+                return false;
+            }else{
+                pos = enqueuePos.load(memory_order_relaxed);
+            }
+        }
+    }
+    
+    bool tryPop(T& out){
+        size_t pos = dequeuePos.load(memory_order_relaxed);
+        for(;;){
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.seq.load(memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if(diff == 0){
+                if(dequeuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)){
+                    out = move(cell.value);
+                    cell.seq.store(pos + mask + 1, memory_order_release);
+                    return true;
+                }
+            }else if(diff < 0){
+                return false;
+            }else{
+                pos = dequeuePos.load(memory_order_relaxed);
+            }
+        }
+    }
+    
+    private:
+    struct Cell {
+        atomic<size_t> seq;
+        T value;
+    };
+    
+    unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) atomic<size_t> enqueuePos{0};
+    alignas(64) atomic<size_t> dequeuePos{0};
+};
+
+/**
+ * @brief Order latency and throughput figures reported by the Kitchen
+ */
+struct KitchenStats {
+    uint64_t completed;
+    uint64_t p50Micros;
+    uint64_t p99Micros;
+    uint64_t maxBatch;
+};
+
+/**
+ * @brief Concurrent kitchen that runs prepration() on a pool of workers
+ * 
+ * Orders are created by a factory on the caller's thread and pushed onto a
+ * bounded MPMC queue. Each worker pops up to batchSize orders at a time,
+ * groups them by concrete burger type (all PremiumWheatBurger together, and
+ * so on) and prepares each group back to back. Every order gets a future
+ * that completes when its burger is ready; latency from submit to ready is
+ * recorded per worker and merged on demand.
+ */
+class Kitchen {
     public:
     /**
-     * @brief Factory method implementation for wheat burger creation
-     * 
-     * @param type String representing the type of wheat burger to create
-     * @return Burger* Pointer to the created wheat burger object, or nullptr if invalid type
-     * 
-     * This method creates wheat burger variants:
-     * - "basic" -> creates BasicWheatBurger
-     * - "standard" -> creates StandarWheatdBurger
-     * - "premium" -> creates PremiumWheatBurger
-     * - any other value -> returns nullptr and prints error message
+     * @throws invalid_argument if workers or batchSize is 0; such a kitchen
+     *         would never prepare an order
      */
-    Burger* createBurger(string& type){
-        if(type == "basic"){
-            return new BasicWheatBurger();
+    Kitchen(size_t workers, size_t capacity = 4096, size_t batchSize = 32) : queue(capacity) {
+        if(workers == 0 || batchSize == 0){
+            throw invalid_argument("Kitchen needs at least one worker and a batch size of at least one");
         }
-        else if(type == "standard"){
-            return new StandarWheatdBurger();
+        this->batchSize = batchSize;
+        maxBatches.assign(workers, 0);
+        for(size_t i = 0; i < workers; i++){
+            pool.emplace_back([this, i]{ work(i); });
         }
-        else if(type == "premium"){
-            return new PremiumWheatBurger();
-        }else{
-            cout<<"Invalid Burger Type, Please Enter Valid Input"<<endl;
-            return nullptr;
+    }
+    
+    ~Kitchen(){
+        stopping.store(true, memory_order_release);
+        for(auto& worker : pool){
+            worker.join();
+        }
+    }
+    
+    /**
+     * @brief Creates the burger with the given factory and queues it
+     * 
+     * @return future that yields BurgerError::None once the burger is
+     *         prepared, or is ready immediately with InvalidType
+     */
+    future<BurgerError> submit(BurgerFactory& factory, string_view type){
+        BurgerResult result = factory.createBurger(type);
+        if(!result.ok()){
+            promise<BurgerError> rejected;
+            rejected.set_value(result.error);
+            return rejected.get_future();
+        }
+        return submit(move(result.burger));
+    }
+    
+    /**
+     * @brief Queues an already created burger, waits while the queue is full
+     */
+    future<BurgerError> submit(BurgerHandle burger){
+        Order order;
+        order.type = &typeid(*burger);
+        order.burger = move(burger);
+        order.enqueued = chrono::steady_clock::now();
+        future<BurgerError> done = order.done.get_future();
+        while(!queue.tryPush(order)){
+            this_thread::yield();
         }
+        return done;
+    }
+    
+    /**
+     * @brief Merges the per-worker latency slots; call after the futures completed
+     */
+    KitchenStats stats(){
+        lock_guard<mutex> guard(statsLock);
+        metrics::HistogramSnapshot all = latency.snapshot();
+        return {all.total, all.percentile(0.50), all.percentile(0.99), *max_element(maxBatches.begin(), maxBatches.end())};
     }
     
+    private:
+    struct Order {
+        BurgerHandle burger;
+        const type_info* type = nullptr;
+        chrono::steady_clock::time_point enqueued;
+        promise<BurgerError> done;
+    };
+    
+    BoundedMpmcQueue<Order> queue;
+    vector<thread> pool;
+    metrics::Histogram latency;         // submit-to-ready, microseconds; one slot per worker thread
+    vector<uint64_t> maxBatches;
+    mutex statsLock;
+    size_t batchSize;
+    atomic<bool> stopping{false};
+    
+    void work(size_t id){
+        vector<Order> batch(batchSize);
+        vector<size_t> order(batchSize);
+        int idle = 0;
+        for(;;){
+            size_t n = 0;
+            while(n < batchSize && queue.tryPop(batch[n])){
+                n++;
+            }
+            if(n == 0){
+                if(stopping.load(memory_order_acquire)) return;
+                // Back off gently: spin, then yield, then sleep
+                if(++idle > 64) this_thread::sleep_for(chrono::microseconds(50));
+                else this_thread::yield();
+                continue;
+            }
+            idle = 0;
+            
+            // Group the batch by concrete type so each group runs back to back
+            iota(order.begin(), order.begin() + n, 0);
+            sort(order.begin(), order.begin() + n, [&](size_t a, size_t b){
+                return batch[a].type->before(*batch[b].type);
+            });
+            
+            for(size_t k = 0; k < n; k++){
+                Order& o = batch[order[k]];
+                o.burger->prepration();
+                o.burger.reset();
+                auto ready = chrono::steady_clock::now();
+                latency.record(chrono::duration_cast<chrono::microseconds>(ready - o.enqueued).count());
+                o.done.set_value(BurgerError::None);
+                o.done = promise<BurgerError>();
+            }
+            lock_guard<mutex> guard(statsLock);
+            maxBatches[id] = max<uint64_t>(maxBatches[id], n);
+        }
+    }
 };
 
+/**
+ * @brief Synthetic load test for the Kitchen
+ * 
+ * Several generator threads submit random orders (including the invalid
+ * "meal") to both factories as fast as the queue accepts them, then wait
+ * for every future. Reports throughput and p50/p99 order latency.
+ */
+void loadTestKitchen(size_t workers, size_t generators, size_t ordersPerGenerator){
+    NullBuffer sink;
+    streambuf* console = cout.rdbuf(&sink);
+    
+    SinghBurger singh;
+    KingBurger king;
+    const string_view menu[] = {"basic", "standard", "premium", "meal"};
+    atomic<uint64_t> rejected{0};
+    
+    auto start = chrono::steady_clock::now();
+    {
+        Kitchen kitchen(workers);
+        vector<thread> load;
+        for(size_t g = 0; g < generators; g++){
+            load.emplace_back([&, g]{
+                mt19937 rng(g + 1);
+                vector<future<BurgerError>> pending;
+                pending.reserve(ordersPerGenerator);
+                for(size_t i = 0; i < ordersPerGenerator; i++){
+                    BurgerFactory& factory = (rng() & 1) ? (BurgerFactory&)singh : (BurgerFactory&)king;
+                    pending.push_back(kitchen.submit(factory, menu[rng() % 4]));
+                }
+                for(auto& f : pending){
+                    if(f.get() != BurgerError::None) rejected++;
+                }
+            });
+        }
+        for(auto& t : load){
+            t.join();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        KitchenStats s = kitchen.stats();
+        
+        cout.rdbuf(console);
+        cout<<"kitchen : "<<workers<<" workers, "<<generators<<" generators"<<endl;
+        cout<<"kitchen : "<<s.completed<<" prepared, "<<rejected<<" rejected, "
+            <<(uint64_t)(s.completed / seconds)<<" orders/sec"<<endl;
+        cout<<"kitchen : p50 "<<s.p50Micros<<"us, p99 "<<s.p99Micros<<"us, largest batch "<<s.maxBatch<<endl;
+    }
+}
+
 /**
  * @brief Main function demonstrating Factory Method pattern usage
  * 
@@ -309,9 +1257,21 @@ class KingBurger : public BurgerFactory{
  * - Polymorphism: Client works with factory interface, not concrete factories
  * - Product Families: Different factories create different product variants
  * - Flexibility: Easy to switch between different factory implementations
+ * 
+ * Run with --bench to compare pooled creation against plain new/delete,
+ * or with --kitchen to load test the concurrent kitchen.
  */
-int main() 
+int main(int argc, char* argv[]) 
 {
+    if(argc > 1 && string(argv[1]) == "--bench") {
+        benchmarkPooling(5000000);
+        return 0;
+    }
+    if(argc > 1 && string(argv[1]) == "--kitchen") {
+        loadTestKitchen(4, 4, 250000);
+        return 0;
+    }
+    
     // Test data for different burger types
     string type1 = "basic";      // Valid type
     string type2 = "premium";    // Valid type  
@@ -327,24 +1287,82 @@ int main()
    
     // Use the factory to create a product
     // The client doesn't need to know about concrete product classes
-    Burger* create = burgerobj->createBurger(type4);
+    BurgerResult create = burgerobj->createBurger(type4);
     
     // Use the created object through the common interface
-    if(create != nullptr) {
-        create->prepration(); // This will call PremiumWheatBurger::prepration()
+    if(create.ok()) {
+        create.burger->prepration(); // This will call StandarWheatdBurger::prepration()
         
-        // Clean up memory (important for proper resource management)
-        delete create;
+        // No delete needed, the handle recycles the burger into its pool
     }
     
     // Demonstrate switching to different factory
     // SinghBurger factory creates regular burger family
     BurgerFactory* singhFactory = new SinghBurger();
-    Burger* regularBurger = singhFactory->createBurger(type1);
+    BurgerResult regularBurger = singhFactory->createBurger(type1);
     
-    if(regularBurger != nullptr) {
-        regularBurger->prepration(); // This will call BasicBurger::prepration()
-        delete regularBurger;
+    if(regularBurger.ok()) {
+        regularBurger.burger->prepration(); // This will call BasicBurger::prepration()
+    }
+    
+    // Invalid types are reported through the result, not printed by the factory
+    BurgerResult meal = singhFactory->createBurger(type3);
+    if(!meal.ok()) {
+        cout<<describe(meal.error)<<endl;
+    }
+    
+    // A batch of orders is created in one block, grouped by burger type
+    vector<string_view> orders = {"basic", "premium", "basic", "meal", "standard", "premium", "basic"};
+    BurgerBatch batch = burgerobj->createBatch(orders);
+    cout<<"batch of "<<batch.size()<<" burgers in "<<batch.runs().size()<<" runs, "<<batch.rejected()<<" rejected"<<endl;
+    batch.prepareAll();
+    
+    // A new family can be plugged in at runtime without touching any factory
+    BurgerRegistry::global().add<PremiumBurger>("ComboBurger", "classic");
+    BurgerRegistry::global().add<PremiumWheatBurger>("ComboBurger", "wheat");
+    RegistryBurgerFactory combo("ComboBurger");
+    BurgerResult comboBurger = combo.createBurger("wheat");
+    if(comboBurger.ok()) {
+        comboBurger.burger->prepration();
+    }
+    cout<<"registry holds "<<BurgerRegistry::global().size()<<" burgers, ComboBurger/basic registered : "
+        <<(BurgerRegistry::global().contains("ComboBurger", "basic") ? "yes" : "no")<<endl;
+    
+    // The kitchen prepares orders on worker threads and hands back futures
+    {
+        Kitchen kitchen(2);
+        future<BurgerError> premium = kitchen.submit(*burgerobj, "premium");
+        future<BurgerError> invalid = kitchen.submit(*singhFactory, type3);
+        premium.wait();
+        cout<<"kitchen order : "<<describe(premium.get())<<endl;
+        cout<<"kitchen order : "<<describe(invalid.get())<<endl;
+    }
+    // Workers release what this thread acquired; the blocks come back through
+    // the pool's overflow stack, so the heap only ever supplies as many as
+    // one round keeps in flight, however many rounds run
+    {
+        NullBuffer sink;
+        streambuf* console = cout.rdbuf(&sink);
+        Kitchen kitchen(2);
+        const int rounds = 5, perRound = 1000;
+        uint64_t before = BurgerPool<PremiumWheatBurger>::allocations();
+        for(int round = 0; round < rounds; round++){
+            vector<future<BurgerError>> orders;
+            for(int i = 0; i < perRound; i++){
+                orders.push_back(kitchen.submit(*burgerobj, "premium"));
+            }
+            for(auto& order : orders){
+                order.wait();
+            }
+        }
+        uint64_t fresh = BurgerPool<PremiumWheatBurger>::allocations() - before;
+        cout.rdbuf(console);
+        cout<<"kitchen pool : "<<fresh<<" allocations for "<<rounds * perRound<<" orders, flat : "<<(fresh <= perRound ? "yes" : "no")<<endl;
+    }
+    try {
+        Kitchen closed(0);
+    } catch(const invalid_argument& e) {
+        cout<<"kitchen rejected : "<<e.what()<<endl;
     }
     
     // Clean up factories
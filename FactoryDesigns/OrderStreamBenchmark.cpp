@@ -0,0 +1,280 @@
+#include <bits/stdc++.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "../Instrumentation/Metrics.h"
+#define ll long long int
+using namespace std;
+
+/**
+ * ORDER STREAM BENCHMARK FOR THE FACTORY DESIGNS
+ *
+ * Replays one synthetic order stream through every factory in this folder:
+ * - simple::BurgerFactory  (SimpleFactory.cpp)
+ * - method::SinghBurger    (FactoryMethod.cpp)
+ * - method::KingBurger     (FactoryMethod.cpp)
+ *
+ * The order stream is a Zipf-distributed mix of burger types, so a few types
+ * dominate like on a real menu, and it includes invalid types such as the
+ * "meal" order from main(). Each run reports:
+ * - ops/sec
+ * - heap allocations per order (global operator new is counted)
+ * - cache misses per order, from perf counters when the kernel allows it
+ * - p50 / p99 / p99.9 latency per order
+ *
+ * Both example files are compiled into this program inside their own
+ * namespace, so a change to dispatch or allocation in either one shows up
+ * here without copying code.
+ *
+ * Build and run:
+ *   g++ -std=c++17 -O2 -pthread OrderStreamBenchmark.cpp -o order_bench
+ *   ./order_bench [orders] [zipf exponent]
+ */
+
+/**
+ * @brief Heap allocations made by this thread, counted by operator new below
+ */
+static thread_local uint64_t allocations = 0;
+
+// The replacements pair malloc with free on purpose, GCC cannot see that
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new(size_t size){
+    allocations++;
+    if(void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+void* operator new(size_t size, align_val_t align){
+    allocations++;
+    size_t a = max((size_t)align, sizeof(void*));
+    if(void* p = aligned_alloc(a, (size + a - 1) / a * a)) return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, align_val_t) noexcept { free(p); }
+void operator delete(void* p, size_t, align_val_t) noexcept { free(p); }
+
+namespace simple {
+#include "SimpleFactory.cpp"
+}
+
+namespace method {
+#include "FactoryMethod.cpp"
+}
+
+/**
+ * @brief Hardware cache-miss counter for the calling thread
+ *
+ * Uses perf_event_open. When the kernel or container does not allow it
+ * (no PMU, perf_event_paranoid too high), available() is false and the
+ * benchmark prints "n/a" instead of a number.
+ */
+class CacheMissCounter {
+    public:
+    CacheMissCounter(){
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    ~CacheMissCounter(){
+        if(fd >= 0) close(fd);
+    }
+
+    bool available() const {
+        return fd >= 0;
+    }
+
+    void start(){
+        if(fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    uint64_t stop(){
+        if(fd < 0) return 0;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t count = 0;
+        if(read(fd, &count, sizeof(count)) != sizeof(count)) return 0;
+        return count;
+    }
+
+    private:
+    int fd;
+};
+
+/**
+ * @brief Generates a Zipf-distributed stream of order keys
+ *
+ * Key k (0-based rank) is drawn with probability proportional to
+ * 1 / (k + 1)^exponent. The whole stream is generated up front so that
+ * sampling cost is not part of the measurement.
+ */
+vector<string_view> makeOrderStream(const vector<string_view>& ranked, size_t orders, double exponent, uint64_t seed){
+    vector<double> cdf(ranked.size());
+    double sum = 0;
+    for(size_t k = 0; k < ranked.size(); k++){
+        sum += 1.0 / pow(k + 1, exponent);
+        cdf[k] = sum;
+    }
+    mt19937_64 rng(seed);
+    uniform_real_distribution<double> uniform(0, sum);
+    vector<string_view> stream(orders);
+    for(size_t i = 0; i < orders; i++){
+        stream[i] = ranked[lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin()];
+    }
+    return stream;
+}
+
+/**
+ * @brief One row of the results table
+ */
+struct RunResult {
+    string name;
+    double opsPerSec;
+    double allocsPerOp;
+    double missesPerOp;
+    bool missesAvailable;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t rejected;
+};
+
+/**
+ * @brief Replays the stream one order at a time: create -> prepration() -> release
+ */
+template<class Factory>
+RunResult runSingle(const string& name, Factory& factory, const vector<string_view>& stream){
+    metrics::Histogram latency;
+    CacheMissCounter misses;
+    uint64_t rejected = 0;
+    uint64_t allocsBefore = allocations;
+
+    misses.start();
+    auto start = chrono::steady_clock::now();
+    for(string_view key : stream){
+        auto t0 = chrono::steady_clock::now();
+        auto result = factory.createBurger(key);
+        if(result.ok()){
+            result.burger->prepration();
+        }else{
+            rejected++;
+        }
+        result.burger.reset();
+        auto t1 = chrono::steady_clock::now();
+        latency.record(chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count());
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    uint64_t missCount = misses.stop();
+
+    double n = stream.size();
+    metrics::HistogramSnapshot snapshot = latency.snapshot();
+    return {name, n / seconds, (allocations - allocsBefore) / n, missCount / n, misses.available(),
+            snapshot.percentile(0.50), snapshot.percentile(0.99), snapshot.percentile(0.999), rejected};
+}
+
+/**
+ * @brief Replays the stream in chunks through createBatch() -> prepareAll()
+ *
+ * Latency is per order, i.e. the chunk time divided by the chunk size.
+ */
+template<class Factory>
+RunResult runBatched(const string& name, Factory& factory, const vector<string_view>& stream, size_t chunk){
+    metrics::Histogram latency;
+    CacheMissCounter misses;
+    uint64_t rejected = 0;
+    uint64_t allocsBefore = allocations;
+
+    misses.start();
+    auto start = chrono::steady_clock::now();
+    for(size_t i = 0; i < stream.size(); i += chunk){
+        size_t count = min(chunk, stream.size() - i);
+        auto t0 = chrono::steady_clock::now();
+        auto batch = factory.createBatch(stream.data() + i, count);
+        batch.prepareAll();
+        rejected += batch.rejected();
+        auto t1 = chrono::steady_clock::now();
+        uint64_t perOrder = chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count() / count;
+        for(size_t k = 0; k < count; k++){
+            latency.record(perOrder);
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    uint64_t missCount = misses.stop();
+
+    double n = stream.size();
+    metrics::HistogramSnapshot snapshot = latency.snapshot();
+    return {name, n / seconds, (allocations - allocsBefore) / n, missCount / n, misses.available(),
+            snapshot.percentile(0.50), snapshot.percentile(0.99), snapshot.percentile(0.999), rejected};
+}
+
+void printResults(const vector<RunResult>& results){
+    cout<<left<<setw(26)<<"factory"<<right<<setw(14)<<"ops/sec"<<setw(12)<<"allocs/op"
+        <<setw(12)<<"misses/op"<<setw(10)<<"p50 ns"<<setw(10)<<"p99 ns"<<setw(11)<<"p99.9 ns"
+        <<setw(10)<<"rejected"<<endl;
+    for(const RunResult& r : results){
+        cout<<left<<setw(26)<<r.name<<right<<fixed<<setprecision(0)<<setw(14)<<r.opsPerSec
+            <<setprecision(2)<<setw(12)<<r.allocsPerOp;
+        if(r.missesAvailable){
+            cout<<setw(12)<<r.missesPerOp;
+        }else{
+            cout<<setw(12)<<"n/a";
+        }
+        cout<<setw(10)<<r.p50<<setw(10)<<r.p99<<setw(11)<<r.p999<<setw(10)<<r.rejected<<endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t orders = argc > 1 ? stoull(argv[1]) : 2000000;
+    double exponent = argc > 2 ? stod(argv[2]) : 1.1;
+    if(orders == 0){
+        // Nothing to time, and every per-order figure would divide by zero
+        cout<<"Error : orders must be at least 1"<<endl;
+        return 1;
+    }
+
+    // Most popular first; the invalid types sit in the tail like real typos
+    vector<string_view> ranked = {"basic", "premium", "standard", "meal", "deluxe", "Basic"};
+    vector<string_view> stream = makeOrderStream(ranked, orders, exponent, 42);
+
+    simple::BurgerFactory simpleFactory;
+    method::SinghBurger singh;
+    method::KingBurger king;
+
+    // Warm up pools and tables once so the first run is not penalised
+    vector<string_view> warmup(stream.begin(), stream.begin() + min<size_t>(stream.size(), 10000));
+
+    method::NullBuffer sink;
+    streambuf* console = cout.rdbuf(&sink);
+    runSingle("warmup", simpleFactory, warmup);
+    runSingle("warmup", singh, warmup);
+    runSingle("warmup", king, warmup);
+
+    vector<RunResult> results;
+    results.push_back(runSingle("simple::BurgerFactory", simpleFactory, stream));
+    results.push_back(runSingle("method::SinghBurger", singh, stream));
+    results.push_back(runSingle("method::KingBurger", king, stream));
+    results.push_back(runBatched("simple::createBatch(256)", simpleFactory, stream, 256));
+    results.push_back(runBatched("method::Singh batch(256)", singh, stream, 256));
+    results.push_back(runBatched("method::King batch(256)", king, stream, 256));
+    cout.rdbuf(console);
+
+    size_t invalid = count_if(ranked.begin(), ranked.end(), [](string_view key){
+        return !method::BurgerRegistry::global().contains("SinghBurger", key);
+    });
+    cout<<orders<<" orders, zipf exponent "<<exponent<<", "<<ranked.size()<<" distinct keys ("<<invalid<<" invalid)"<<endl;
+    printResults(results);
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include <bits/stdc++.h>
+#include "../Instrumentation/Metrics.h"
 #define ll long long int 
 using namespace std;
 
@@ -103,6 +104,440 @@ class PremiumBurger : public Burger{
 };
 
 
+/**
+ * @brief Per-type, per-thread free list of burger objects
+ * 
+ * Creating a burger used to be a new/delete pair for a tiny object. The pool
+ * keeps released blocks of sizeof(T) on a thread local free list and hands
+ * them back on the next acquire(), so steady-state creation never reaches
+ * malloc. A block released on another thread simply joins that thread's list.
+ */
+template<class T>
+class BurgerPool {
+    public:
+    /**
+     * @brief Constructs a T in a recycled block, or a fresh one if the list is empty
+     */
+    static T* acquire(){
+        FreeList& list = local();
+        void* mem;
+        if(list.head != nullptr){
+            mem = list.head;
+            list.head = list.head->next;
+            list.count--;
+        }else{
+            mem = ::operator new(sizeof(T));
+        }
+        return new(mem) T();
+    }
+    
+    /**
+     * @brief Destroys the burger and keeps its block for the next acquire()
+     */
+    static void release(Burger* burger){
+        T* object = static_cast<T*>(burger);
+        object->~T();
+        FreeList& list = local();
+        if(list.count >= MAX_CACHED){
+            ::operator delete(object);
+            return;
+        }
+        Node* node = reinterpret_cast<Node*>(object);
+        node->next = list.head;
+        list.head = node;
+        list.count++;
+    }
+    
+    private:
+    static const size_t MAX_CACHED = 4096;
+    
+    struct Node {
+        Node* next;
+    };
+    
+    struct FreeList {
+        Node* head = nullptr;
+        size_t count = 0;
+        
+        ~FreeList(){
+            while(head != nullptr){
+                Node* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    };
+    
+    static FreeList& local(){
+        thread_local FreeList list;
+        return list;
+    }
+};
+
+/**
+ * @brief Deleter that sends a burger back to the pool it came from
+ */
+struct BurgerRecycler {
+    void (*recycle)(Burger*) = nullptr;
+    
+    void operator()(Burger* burger) const {
+        recycle(burger);
+    }
+};
+
+/**
+ * @brief Owning handle to a pooled burger, recycles it when it goes out of scope
+ */
+typedef unique_ptr<Burger, BurgerRecycler> BurgerHandle;
+
+/**
+ * @brief Creates a pooled burger of type T
+ */
+template<class T>
+BurgerHandle makeBurger(){
+    return BurgerHandle(BurgerPool<T>::acquire(), BurgerRecycler{&BurgerPool<T>::release});
+}
+
+/**
+ * @brief Reason a burger could not be created
+ */
+enum class BurgerError {
+    None,
+    InvalidType
+};
+
+/**
+ * @brief Returns a human readable message for a BurgerError
+ */
+const char* describe(BurgerError error){
+    switch(error){
+        case BurgerError::None: return "OK";
+        case BurgerError::InvalidType: return "Invalid Burger Type, Please Enter Valid Input";
+    }
+    return "Unknown Error";
+}
+
+/**
+ * @brief Result of a createBurger() call
+ * 
+ * Either holds the created burger, or a null burger and the reason it
+ * could not be created. The factory no longer prints errors itself;
+ * the caller decides how to report them. The burger is returned to its
+ * pool when the handle goes out of scope, so callers never delete it.
+ */
+struct BurgerResult {
+    BurgerHandle burger;
+    BurgerError error;
+    
+    bool ok() const {
+        return error == BurgerError::None;
+    }
+};
+
+/**
+ * @brief A batch of burgers stored contiguously and grouped by concrete type
+ * 
+ * createBatch() counts how many of each type were ordered, allocates one
+ * block and constructs every burger of the same type next to each other.
+ * prepareAll() then walks one homogeneous run at a time, so the virtual
+ * prepration() call keeps hitting the same target and stays predictable.
+ */
+class BurgerBatch {
+    public:
+    /**
+     * @brief Consecutive burgers of one concrete type
+     */
+    struct Run {
+        Burger* first;
+        size_t count;
+        size_t stride;
+        
+        Burger* at(size_t i) const {
+            return reinterpret_cast<Burger*>(reinterpret_cast<char*>(first) + i * stride);
+        }
+    };
+    
+    BurgerBatch() = default;
+    BurgerBatch(const BurgerBatch&) = delete;
+    BurgerBatch& operator=(const BurgerBatch&) = delete;
+    
+    BurgerBatch(BurgerBatch&& other) noexcept {
+        *this = move(other);
+    }
+    
+    BurgerBatch& operator=(BurgerBatch&& other) noexcept {
+        if(this != &other){
+            destroy();
+            storage = other.storage;
+            runList = move(other.runList);
+            orders = move(other.orders);
+            invalid = other.invalid;
+            other.storage = nullptr;
+            other.runList.clear();
+            other.orders.clear();
+            other.invalid = 0;
+        }
+        return *this;
+    }
+    
+    ~BurgerBatch(){
+        destroy();
+    }
+    
+    /**
+     * @brief Calls prepration() on every burger, one concrete type at a time
+     */
+    void prepareAll(){
+        for(const Run& run : runList){
+            for(size_t i = 0; i < run.count; i++){
+                run.at(i)->prepration();
+            }
+        }
+    }
+    
+    const vector<Run>& runs() const {
+        return runList;
+    }
+    
+    /**
+     * @brief Burger created for the i-th key, nullptr if that key was invalid
+     */
+    Burger* operator[](size_t i) const {
+        return orders[i];
+    }
+    
+    size_t size() const {
+        return orders.size() - invalid;
+    }
+    
+    size_t rejected() const {
+        return invalid;
+    }
+    
+    private:
+    friend class BurgerMenu;
+    
+    static const size_t ALIGNMENT = 64;
+    
+    void* storage = nullptr;
+    vector<Run> runList;
+    vector<Burger*> orders;
+    size_t invalid = 0;
+    
+    void destroy(){
+        for(const Run& run : runList){
+            for(size_t i = 0; i < run.count; i++){
+                run.at(i)->~Burger();
+            }
+        }
+        runList.clear();
+        if(storage != nullptr){
+            ::operator delete(storage, align_val_t(ALIGNMENT));
+            storage = nullptr;
+        }
+    }
+};
+
+/**
+ * @brief Registration based menu mapping a type key to a constructor
+ * 
+ * Replaces the if/else chain of string comparisons. Each burger type is
+ * registered once with add<T>("key"); lookups hash the key and probe a
+ * flat open-addressing table, so createBurger() is O(1) and does not
+ * allocate. Keys are copied into the menu, so callers can register
+ * names that are only known at runtime.
+ */
+class BurgerMenu {
+    public:
+    typedef BurgerHandle (*Constructor)();
+    typedef Burger* (*Placer)(void*);
+    
+    /**
+     * @brief Registers burger type T under the given key
+     * 
+     * Registering an existing key replaces its constructor.
+     */
+    template<class T>
+    void add(string_view type){
+        insert(type, &makeBurger<T>, &placeBurger<T>, sizeof(T), alignof(T));
+    }
+    
+    /**
+     * @brief Creates the burger registered under type
+     * 
+     * @param type Key to look up, e.g. "basic"
+     * @return BurgerResult with the new burger, or BurgerError::InvalidType
+     */
+    BurgerResult create(string_view type) const {
+        const Slot* slot = find(type);
+        if(slot == nullptr){
+            return {nullptr, BurgerError::InvalidType};
+        }
+        return {slot->make(), BurgerError::None};
+    }
+    
+    /**
+     * @brief Creates one burger per key in a single contiguous block
+     * 
+     * @param keys Type keys, one per ordered burger
+     * @param count Number of keys
+     * @return BurgerBatch with the burgers grouped by concrete type; invalid
+     *         keys are counted in rejected() and map to nullptr
+     */
+    BurgerBatch createBatch(const string_view* keys, size_t count) const {
+        BurgerBatch batch;
+        vector<const Slot*> resolved(count);
+        vector<size_t> perGroup(groups.size(), 0);
+        for(size_t i = 0; i < count; i++){
+            resolved[i] = find(keys[i]);
+            if(resolved[i] == nullptr){
+                batch.invalid++;
+            }else{
+                perGroup[resolved[i]->group]++;
+            }
+        }
+        
+        // Lay the runs out back to back, each starting on its type's alignment
+        vector<size_t> offset(groups.size(), 0);
+        size_t bytes = 0;
+        for(size_t g = 0; g < groups.size(); g++){
+            if(perGroup[g] == 0) continue;
+            bytes = (bytes + groups[g].align - 1) / groups[g].align * groups[g].align;
+            offset[g] = bytes;
+            bytes += perGroup[g] * groups[g].size;
+        }
+        if(bytes > 0){
+            batch.storage = ::operator new(bytes, align_val_t(BurgerBatch::ALIGNMENT));
+        }
+        
+        vector<size_t> runOf(groups.size(), 0);
+        for(size_t g = 0; g < groups.size(); g++){
+            if(perGroup[g] == 0) continue;
+            runOf[g] = batch.runList.size();
+            batch.runList.push_back({nullptr, 0, groups[g].size});
+        }
+        batch.orders.resize(count, nullptr);
+        for(size_t i = 0; i < count; i++){
+            if(resolved[i] == nullptr) continue;
+            uint32_t g = resolved[i]->group;
+            BurgerBatch::Run& run = batch.runList[runOf[g]];
+            char* mem = static_cast<char*>(batch.storage) + offset[g] + run.count * run.stride;
+            Burger* burger = groups[g].place(mem);
+            if(run.count == 0){
+                run.first = burger;
+            }
+            run.count++;
+            batch.orders[i] = burger;
+        }
+        return batch;
+    }
+    
+    BurgerBatch createBatch(const vector<string_view>& keys) const {
+        return createBatch(keys.data(), keys.size());
+    }
+    
+    bool contains(string_view type) const {
+        return find(type) != nullptr;
+    }
+    
+    size_t size() const {
+        return used;
+    }
+    
+    private:
+    struct Slot {
+        string_view key;
+        uint64_t hash = 0;
+        Constructor make = nullptr;
+        uint32_t group = 0;
+    };
+    
+    /**
+     * @brief One entry per concrete type, shared by every key that maps to it
+     */
+    struct Group {
+        Placer place;
+        size_t size;
+        size_t align;
+    };
+    
+    vector<Slot> slots = vector<Slot>(16);
+    vector<Group> groups;
+    deque<string> names;    // owns the key bytes, deque keeps them in place
+    size_t used = 0;
+    
+    template<class T>
+    static Burger* placeBurger(void* mem){
+        return new(mem) T();
+    }
+    
+    /**
+     * @brief FNV-1a hash of the key
+     */
+    static uint64_t hash(string_view key){
+        uint64_t h = 1469598103934665603ULL;
+        for(char c : key){
+            h ^= (unsigned char)c;
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+    
+    const Slot* find(string_view type) const {
+        uint64_t h = hash(type);
+        size_t mask = slots.size() - 1;
+        for(size_t i = h & mask; ; i = (i + 1) & mask){
+            const Slot& slot = slots[i];
+            if(slot.make == nullptr){
+                return nullptr;
+            }
+            if(slot.hash == h && slot.key == type){
+                return &slot;
+            }
+        }
+    }
+    
+    void place(vector<Slot>& table, const Slot& entry){
+        size_t mask = table.size() - 1;
+        size_t i = entry.hash & mask;
+        while(table[i].make != nullptr && !(table[i].hash == entry.hash && table[i].key == entry.key)){
+            i = (i + 1) & mask;
+        }
+        table[i] = entry;
+    }
+    
+    uint32_t groupFor(Placer placer, size_t size, size_t align){
+        for(uint32_t g = 0; g < groups.size(); g++){
+            if(groups[g].place == placer) return g;
+        }
+        groups.push_back({placer, size, align});
+        return groups.size() - 1;
+    }
+    
+    void insert(string_view type, Constructor make, Placer placer, size_t size, size_t align){
+        uint32_t group = groupFor(placer, size, align);
+        Slot* existing = const_cast<Slot*>(find(type));
+        if(existing != nullptr){
+            existing->make = make;
+            existing->group = group;
+            return;
+        }
+        // Keep the load factor at or below one half so probe runs stay short
+        if((used + 1) * 2 > slots.size()){
+            vector<Slot> bigger(slots.size() * 2);
+            for(const Slot& slot : slots){
+                if(slot.make != nullptr){
+                    place(bigger, slot);
+                }
+            }
+            slots.swap(bigger);
+        }
+        names.emplace_back(type);
+        place(slots, {names.back(), hash(type), make, group});
+        used++;
+    }
+};
+
 /**
  * @brief Factory class for creating Burger objects
  * 
@@ -114,34 +549,69 @@ class PremiumBurger : public Burger{
  * - Centralizes object creation logic
  * - Makes it easy to add new burger types
  * - Client code doesn't need to know about concrete classes
+ * 
+ * The burger types are registered in a BurgerMenu once, so adding a type
+ * is one add<T>() call instead of another branch in createBurger().
  */
 class BurgerFactory {
+    private:
+    BurgerMenu menu;
+    
     public:
     /**
-     * @brief Factory method to create Burger objects
+     * @brief Registers the burger types this factory can create
      * 
-     * @param type String representing the type of burger to create
-     * @return Burger* Pointer to the created burger object, or nullptr if invalid type
+     * - "basic" -> BasicBurger
+     * - "standard" -> StandardBurger
+     * - "premium" -> PremiumBurger
+     */
+    BurgerFactory(){
+        menu.add<BasicBurger>("basic");
+        menu.add<StandardBurger>("standard");
+        menu.add<PremiumBurger>("premium");
+    }
+    
+    /**
+     * @brief Factory method to create Burger objects
      * 
-     * This method implements the factory logic:
-     * - "basic" -> creates BasicBurger
-     * - "standard" -> creates StandardBurger  
-     * - "premium" -> creates PremiumBurger
-     * - any other value -> returns nullptr and prints error message
+     * @param type Key of the burger type to create
+     * @return BurgerResult holding the created burger, or BurgerError::InvalidType
+     *         if the type is not on the menu
      */
-    Burger* createBurger(string& type){
-        if(type == "basic"){
-            return new BasicBurger();
-        }
-        else if(type == "standard"){
-            return new StandardBurger();
-        }
-        else if(type == "premium"){
-            return new PremiumBurger();
+    BurgerResult createBurger(string_view type){
+        METRIC_TIMER("simple_factory_create_ns");
+        BurgerResult result = menu.create(type);
+        if(result.ok()){
+            METRIC_COUNT("simple_factory_created_total", 1);
         }else{
-            cout<<"Invalid Burger Type, Please Enter Valid Input"<<endl;
-            return nullptr;
+            METRIC_COUNT("simple_factory_rejected_total", 1);
         }
+        return result;
+    }
+    
+    /**
+     * @brief Creates a whole order batch in one contiguous block
+     * 
+     * @param keys Type keys of the ordered burgers
+     * @param count Number of keys
+     * @return BurgerBatch grouped by concrete type, ready for prepareAll()
+     */
+    BurgerBatch createBatch(const string_view* keys, size_t count){
+        METRIC_TIMER("simple_factory_batch_ns");
+        METRIC_COUNT("simple_factory_batch_orders_total", count);
+        return menu.createBatch(keys, count);
+    }
+    
+    BurgerBatch createBatch(const vector<string_view>& keys){
+        return createBatch(keys.data(), keys.size());
+    }
+    
+    /**
+     * @brief Adds a new burger type to the menu at runtime
+     */
+    template<class T>
+    void addBurger(string_view type){
+        menu.add<T>(type);
     }
 };
 
@@ -167,16 +637,27 @@ int main()
    
     // Demonstrate factory usage
     // Client requests a burger through the factory without knowing the concrete class
-    Burger* create = burgerobj->createBurger(type4);
+    BurgerResult create = burgerobj->createBurger(type4);
     
     // Use the created object through the common interface
-    if(create != nullptr) {
-        create->prepration();
+    if(create.ok()) {
+        create.burger->prepration();
         
-        // Clean up memory (important for proper resource management)
-        delete create;
+        // No delete needed, the handle recycles the burger into its pool
     }
     
+    // Invalid types are reported through the result, not printed by the factory
+    BurgerResult invalid = burgerobj->createBurger(type3);
+    if(!invalid.ok()) {
+        cout<<describe(invalid.error)<<endl;
+    }
+    
+    // A batch of orders is created in one block, grouped by burger type
+    vector<string_view> orders = {"basic", "premium", "basic", "meal", "standard", "premium", "basic"};
+    BurgerBatch batch = burgerobj->createBatch(orders);
+    cout<<"batch of "<<batch.size()<<" burgers in "<<batch.runs().size()<<" runs, "<<batch.rejected()<<" rejected"<<endl;
+    batch.prepareAll();
+    
     // Clean up factory
     delete burgerobj;
 
@@ -0,0 +1,316 @@
+#pragma once
+#include <bits/stdc++.h>
+using namespace std;
+
+/*
+ * METRICS - counters, latency histograms and scoped timers for the examples
+ *
+ * Every example includes this header and marks its main operations:
+ *
+ *   void addText(string text){
+ *       METRIC_COUNT("editor_elements_added", 1);
+ *       METRIC_TIMER("editor_add_ns");
+ *       ...
+ *   }
+ *
+ * - Counters and histograms keep one slot per thread, so the hot path is a
+ *   plain load and store on memory no other thread writes: no lock, no
+ *   atomic read-modify-write, no shared cache line
+ * - Histograms are HDR style: log-linear buckets with 16 sub-buckets per
+ *   power of two, so any value is stored with about 6% error
+ * - Reading (dump) merges the per-thread slots and may run at any time
+ * - Build with -DLLD_METRICS=0 and the macros expand to nothing
+ *
+ * Output: Registry::global().dump(out) writes a Prometheus-style text page.
+ * If the environment variable LLD_METRICS_FILE is set, the page is written
+ * to that file at exit; FileExporter rewrites it periodically, which stands
+ * in for a /metrics endpoint that a scraper can poll.
+ */
+
+#ifndef LLD_METRICS
+#define LLD_METRICS 1
+#endif
+
+namespace metrics {
+
+// Threads beyond this count share one overflow slot, updated atomically.
+const int MAX_THREADS = 256;
+
+inline int threadSlot(){
+    static atomic<int> next{0};
+    thread_local int slot = min(next.fetch_add(1, memory_order_relaxed), MAX_THREADS);
+    return slot;
+}
+
+// Adds n to a slot. Each slot below MAX_THREADS has exactly one writer, so
+// a relaxed load and store is enough; the overflow slot is shared.
+inline void bump(atomic<uint64_t>& cell, uint64_t n, int slot){
+    if(slot < MAX_THREADS){
+        cell.store(cell.load(memory_order_relaxed) + n, memory_order_relaxed);
+    }else{
+        cell.fetch_add(n, memory_order_relaxed);
+    }
+}
+
+class Counter{
+    public:
+    void add(uint64_t n){
+        int slot = threadSlot();
+        bump(cells[slot].value, n, slot);
+    }
+
+    uint64_t value() const {
+        uint64_t sum = 0;
+        for(const Cell& c : cells){
+            sum += c.value.load(memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    private:
+    struct alignas(64) Cell{
+        atomic<uint64_t> value{0};
+    };
+
+    array<Cell, MAX_THREADS + 1> cells;
+};
+
+// Merged view of a Histogram at one point in time.
+struct HistogramSnapshot{
+    vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t sum = 0;
+
+    uint64_t percentile(double q) const;
+};
+
+class Histogram{
+    public:
+    static const int SUB_BITS = 4;
+    static const size_t BUCKETS = 64 << SUB_BITS;
+
+    ~Histogram(){
+        for(auto& s : slots){
+            delete s.load(memory_order_relaxed);
+        }
+    }
+
+    void record(uint64_t value){
+        int slot = threadSlot();
+        Buckets* b = slots[slot].load(memory_order_acquire);
+        if(b == nullptr){
+            b = claim(slot);
+        }
+        bump(b->counts[bucketOf(value)], 1, slot);
+        bump(b->sum, value, slot);
+    }
+
+    HistogramSnapshot snapshot() const {
+        HistogramSnapshot s;
+        s.counts.assign(BUCKETS, 0);
+        for(const auto& slot : slots){
+            const Buckets* b = slot.load(memory_order_acquire);
+            if(b == nullptr) continue;
+            for(size_t i = 0; i < BUCKETS; i++){
+                uint64_t c = b->counts[i].load(memory_order_relaxed);
+                s.counts[i] += c;
+                s.total += c;
+            }
+            s.sum += b->sum.load(memory_order_relaxed);
+        }
+        return s;
+    }
+
+    static size_t bucketOf(uint64_t v){
+        if(v < (1u << SUB_BITS)) return v;
+        int top = 63 - __builtin_clzll(v);
+        int shift = top - SUB_BITS;
+        return ((size_t)(shift + 1) << SUB_BITS) + ((v >> shift) & ((1u << SUB_BITS) - 1));
+    }
+
+    static uint64_t upperBound(size_t bucket){
+        if(bucket < (1u << SUB_BITS)) return bucket;
+        size_t shift = (bucket >> SUB_BITS) - 1;
+        uint64_t sub = bucket & ((1u << SUB_BITS) - 1);
+        return (((1ULL << SUB_BITS) + sub + 1) << shift) - 1;
+    }
+
+    private:
+    struct Buckets{
+        array<atomic<uint64_t>, BUCKETS> counts{};
+        atomic<uint64_t> sum{0};
+    };
+
+    // Buckets are allocated the first time a thread records, so a
+    // histogram costs nothing for threads that never touch it.
+    Buckets* claim(int slot){
+        Buckets* fresh = new Buckets();
+        Buckets* expected = nullptr;
+        if(slots[slot].compare_exchange_strong(expected, fresh, memory_order_acq_rel)){
+            return fresh;
+        }
+        delete fresh;
+        return expected;
+    }
+
+    array<atomic<Buckets*>, MAX_THREADS + 1> slots{};
+};
+
+inline uint64_t HistogramSnapshot::percentile(double q) const {
+    if(total == 0) return 0;
+    uint64_t rank = max<uint64_t>(1, (uint64_t)ceil(q * total));
+    uint64_t seen = 0;
+    for(size_t i = 0; i < counts.size(); i++){
+        seen += counts[i];
+        if(seen >= rank) return Histogram::upperBound(i);
+    }
+    return Histogram::upperBound(counts.size() - 1);
+}
+
+// Records the lifetime of the enclosing scope, in nanoseconds.
+class ScopedTimer{
+    public:
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram(histogram), start(chrono::steady_clock::now()) {}
+
+    ~ScopedTimer(){
+        histogram.record(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+    Histogram& histogram;
+    chrono::steady_clock::time_point start;
+};
+
+// Named counters and histograms. Lookups take a lock, so the macros do them
+// once per call site and keep the reference in a function-local static.
+class Registry{
+    public:
+    // Never destroyed, so metrics stay valid in other objects' destructors.
+    static Registry& global(){
+        static Registry* registry = new Registry();
+        return *registry;
+    }
+
+    Counter& counter(const string& name){
+        lock_guard<mutex> guard(lock);
+        auto it = counters.find(name);
+        if(it == counters.end()){
+            it = counters.emplace(name, make_unique<Counter>()).first;
+        }
+        return *it->second;
+    }
+
+    Histogram& histogram(const string& name){
+        lock_guard<mutex> guard(lock);
+        auto it = histograms.find(name);
+        if(it == histograms.end()){
+            it = histograms.emplace(name, make_unique<Histogram>()).first;
+        }
+        return *it->second;
+    }
+
+    // Prometheus-style text: one line per counter, and count, sum and
+    // quantiles per histogram.
+    void dump(ostream& out){
+        lock_guard<mutex> guard(lock);
+        for(auto& [name, c] : counters){
+            out<<"# TYPE "<<name<<" counter\n";
+            out<<name<<" "<<c->value()<<"\n";
+        }
+        for(auto& [name, h] : histograms){
+            HistogramSnapshot s = h->snapshot();
+            out<<"# TYPE "<<name<<" summary\n";
+            for(double q : {0.5, 0.99, 0.999}){
+                out<<name<<"{quantile=\""<<q<<"\"} "<<s.percentile(q)<<"\n";
+            }
+            out<<name<<"_count "<<s.total<<"\n";
+            out<<name<<"_sum "<<s.sum<<"\n";
+        }
+    }
+
+    // Writes the page to a temporary file and renames it over path, so a
+    // reader never sees a half-written page.
+    bool writeFile(const string& path){
+        string tmp = path + ".tmp";
+        {
+            ofstream out(tmp);
+            if(!out) return false;
+            dump(out);
+            if(!out) return false;
+        }
+        return rename(tmp.c_str(), path.c_str()) == 0;
+    }
+
+    private:
+    Registry() {}
+
+    mutex lock;
+    map<string, unique_ptr<Counter>> counters;
+    map<string, unique_ptr<Histogram>> histograms;
+};
+
+// Rewrites the metrics file every interval on a background thread.
+class FileExporter{
+    public:
+    FileExporter(string path, chrono::milliseconds interval)
+        : path(move(path)), interval(interval), worker([this]{ run(); }) {}
+
+    ~FileExporter(){
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+        Registry::global().writeFile(path);
+    }
+
+    private:
+    void run(){
+        unique_lock<mutex> guard(lock);
+        while(!wake.wait_for(guard, interval, [this]{ return stopping; })){
+            Registry::global().writeFile(path);
+        }
+    }
+
+    string path;
+    chrono::milliseconds interval;
+    mutex lock;
+    condition_variable wake;
+    bool stopping = false;
+    thread worker;
+};
+
+// Writes the page to $LLD_METRICS_FILE, if set, when the program exits.
+struct ExitDump{
+    ~ExitDump(){
+        if(const char* path = getenv("LLD_METRICS_FILE")){
+            Registry::global().writeFile(path);
+        }
+    }
+};
+
+inline ExitDump exitDump;
+
+}
+
+#define METRICS_CONCAT_(a, b) a##b
+#define METRICS_CONCAT(a, b) METRICS_CONCAT_(a, b)
+
+#if LLD_METRICS
+#define METRIC_COUNT(name, n) \
+    do { \
+        static ::metrics::Counter& metricsCounter = ::metrics::Registry::global().counter(name); \
+        metricsCounter.add(n); \
+    } while(0)
+#define METRIC_TIMER(name) \
+    static ::metrics::Histogram& METRICS_CONCAT(metricsHistogram, __LINE__) = ::metrics::Registry::global().histogram(name); \
+    ::metrics::ScopedTimer METRICS_CONCAT(metricsTimer, __LINE__)(METRICS_CONCAT(metricsHistogram, __LINE__))
+#else
+#define METRIC_COUNT(name, n) do {} while(0)
+#define METRIC_TIMER(name) do {} while(0)
+#endif
@@ -1,10 +1,325 @@
 #include <bits/stdc++.h>
+#include "../Instrumentation/Metrics.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 #define ll long long int 
 using namespace std;
 
+// Structure-of-arrays kinematic state for every robot of one archetype.
+// Walking moves a robot on the ground plane (x, y), flying moves its altitude (z).
+// The kernels integrate rows [0, active()). A batch on its own integrates
+// every row; RobotFleet sets awake to the number of awake robots and keeps
+// the sleeping ones in the rows after them.
+struct KinematicBatch{
+    static const size_t ALL_ROWS = SIZE_MAX;
+    
+    vector<float> x, y, z;
+    vector<float> vx, vy, vz;
+    size_t awake = ALL_ROWS;
+    
+    size_t size() const{
+        return x.size();
+    }
+    
+    size_t active() const{
+        return awake < size() ? awake : size();
+    }
+};
+
+// pos[i] += vel[i] * dt over a whole column. The AVX2 kernel does a plain
+// multiply then add (no FMA) so it gives bit-identical results to the scalar one.
+typedef void (*IntegrateFn)(float* pos, const float* vel, size_t n, float dt);
+
+static void integrateScalar(float* pos, const float* vel, size_t n, float dt){
+    for(size_t i = 0; i < n; i++){
+        pos[i] += vel[i] * dt;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static void integrateAVX2(float* pos, const float* vel, size_t n, float dt){
+    __m256 step = _mm256_set1_ps(dt);
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        __m256 p = _mm256_loadu_ps(pos + i);
+        __m256 v = _mm256_loadu_ps(vel + i);
+        _mm256_storeu_ps(pos + i, _mm256_add_ps(p, _mm256_mul_ps(v, step)));
+    }
+    for(; i < n; i++){
+        pos[i] += vel[i] * dt;
+    }
+}
+#endif
+
+static IntegrateFn resolveIntegrate(const char** name){
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")){
+        *name = "avx2";
+        return integrateAVX2;
+    }
+#endif
+    *name = "scalar";
+    return integrateScalar;
+}
+
+// Picked once on first use, every batch call after that is one indirect call.
+static IntegrateFn integrateKernel(const char** name = nullptr){
+    static const char* kernelName = nullptr;
+    static IntegrateFn fn = resolveIntegrate(&kernelName);
+    if(name) *name = kernelName;
+    return fn;
+}
+
+struct Message{
+    uint32_t from;
+    uint32_t to;
+    uint64_t payload;
+};
+
+// Single-producer single-consumer ring. The producer only touches tail and its
+// own counters, the consumer only touches head, so neither side takes a lock or
+// does an atomic read-modify-write.
+template<class T>
+class SpscRing{
+    private:
+    vector<T> slots;
+    size_t mask;
+    alignas(64) atomic<size_t> head{0};
+    alignas(64) atomic<size_t> tail{0};
+    size_t cachedHead = 0;
+    atomic<uint64_t> full{0};          // pushes refused because the ring was full
+    atomic<uint64_t> muted{0};
+    
+    static void bump(atomic<uint64_t>& counter){
+        counter.store(counter.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    }
+    
+    public:
+    SpscRing(size_t capacity){
+        size_t cap = 1;
+        while(cap < capacity) cap <<= 1;
+        slots.resize(cap);
+        mask = cap - 1;
+    }
+    
+    bool push(const T& value){
+        size_t t = tail.load(memory_order_relaxed);
+        if(t - cachedHead == slots.size()){
+            cachedHead = head.load(memory_order_acquire);
+            if(t - cachedHead == slots.size()){
+                bump(full);
+                return false;
+            }
+        }
+        slots[t & mask] = value;
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+    
+    void mute(){
+        bump(muted);
+    }
+    
+    // Hands everything published so far to f in one batch.
+    template<class F>
+    size_t drain(F&& f){
+        size_t h = head.load(memory_order_relaxed);
+        size_t t = tail.load(memory_order_acquire);
+        for(size_t i = h; i < t; i++){
+            f(slots[i & mask]);
+        }
+        head.store(t, memory_order_release);
+        return t - h;
+    }
+    
+    size_t depth(){
+        return tail.load(memory_order_acquire) - head.load(memory_order_acquire);
+    }
+    
+    uint64_t pushed(){
+        return tail.load(memory_order_acquire);
+    }
+    
+    uint64_t rejectedFull(){
+        return full.load(memory_order_relaxed);
+    }
+    
+    uint64_t droppedMuted(){
+        return muted.load(memory_order_relaxed);
+    }
+};
+
+class RobotFleet;
+
+struct BusMetrics{
+    uint64_t sent = 0;
+    uint64_t delivered = 0;
+    uint64_t backpressure = 0;      // sends refused on a full ring; the sender may retry
+    uint64_t droppedMuted = 0;
+    uint64_t droppedRange = 0;
+    uint64_t droppedUnknown = 0;    // sender or recipient is not a robot of the fleet
+    uint64_t droppedNoQueue = 0;    // sender thread found all MAX_QUEUES rings held by live threads
+    size_t queues = 0;
+    size_t queueDepth = 0;
+    size_t maxQueueDepth = 0;
+};
+
+// In-process message bus for robot talk(). Every sending thread gets its own
+// SPSC ring, so together they form an MPSC queue with no shared lock on send.
+// deliver() runs once per tick on the simulation thread: it drains every ring
+// in one batch, drops messages whose recipient is out of range and groups the
+// rest by recipient.
+class MessageBus{
+    private:
+    static const size_t MAX_QUEUES = 256;
+    
+    // Rings this thread sends on, in every bus it has sent on. They are handed
+    // back when the thread exits, if the bus is still alive; whatever is left
+    // in a ring is still delivered, and the next new sender reuses it.
+    struct ThreadRings{
+        vector<pair<uint64_t, size_t>> held;  // bus serial, ring
+        
+        ~ThreadRings(){
+            lock_guard<mutex> guard(liveLock());
+            for(auto& h:held){
+                auto it = live().find(h.first);
+                if(it != live().end()){
+                    it->second->taken[h.second].store(false, memory_order_release);
+                }
+            }
+        }
+    };
+    
+    array<unique_ptr<SpscRing<Message>>, MAX_QUEUES> rings;
+    array<atomic<bool>, MAX_QUEUES> taken{};    // ring has a live sending thread
+    atomic<size_t> ringCount{0};
+    mutex registerLock;
+    size_t ringCapacity;
+    float range;
+    uint64_t serial;
+    
+    vector<Message> inbox;
+    uint64_t delivered = 0;
+    uint64_t outOfRange = 0;
+    uint64_t unknownRobot = 0;
+    atomic<uint64_t> noQueue{0};
+    
+    static atomic<uint64_t>& serials(){
+        static atomic<uint64_t> next{1};
+        return next;
+    }
+    
+    static mutex& liveLock(){
+        static mutex* lock = new mutex();
+        return *lock;
+    }
+    
+    static unordered_map<uint64_t, MessageBus*>& live(){
+        static auto* buses = new unordered_map<uint64_t, MessageBus*>();
+        return *buses;
+    }
+    
+    // Slow path, taken once per thread per bus. A ring released by an exited
+    // thread is reused before a new one is made; acquiring its taken flag
+    // orders the new producer after the old one. Entries for buses that are
+    // gone are dropped here so the fast path stays short.
+    SpscRing<Message>* registerThread(vector<pair<uint64_t, size_t>>& held){
+        {
+            lock_guard<mutex> guard(liveLock());
+            held.erase(remove_if(held.begin(), held.end(), [](const pair<uint64_t, size_t>& h){ return !live().count(h.first); }), held.end());
+        }
+        lock_guard<mutex> guard(registerLock);
+        size_t n = ringCount.load(memory_order_relaxed);
+        size_t i = 0;
+        while(i < n && taken[i].load(memory_order_acquire)) i++;
+        if(i == MAX_QUEUES){
+            return nullptr;
+        }
+        if(i == n){
+            rings[i].reset(new SpscRing<Message>(ringCapacity));
+            ringCount.store(n + 1, memory_order_release);
+        }
+        taken[i].store(true, memory_order_relaxed);
+        held.push_back({serial, i});
+        return rings[i].get();
+    }
+    
+    // The per-thread cache is keyed by bus, so a thread sending on several
+    // buses stays on the fast path for each of them.
+    SpscRing<Message>* queue(){
+        thread_local ThreadRings mine;
+        for(auto& h:mine.held){
+            if(h.first == serial) return rings[h.second].get();
+        }
+        return registerThread(mine.held);
+    }
+    
+    public:
+    MessageBus(float range, size_t ringCapacity = 1 << 16){
+        this->range = range;
+        this->ringCapacity = ringCapacity;
+        this->serial = serials().fetch_add(1);
+        lock_guard<mutex> guard(liveLock());
+        live()[serial] = this;
+    }
+    
+    ~MessageBus(){
+        lock_guard<mutex> guard(liveLock());
+        live().erase(serial);
+    }
+    
+    bool send(const Message& msg){
+        SpscRing<Message>* q = queue();
+        if(!q){
+            noQueue.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+        return q->push(msg);
+    }
+    
+    void mute(){
+        SpscRing<Message>* q = queue();
+        if(q) q->mute();
+    }
+    
+    size_t deliver(RobotFleet& fleet);
+    
+    // Messages delivered to one robot in the last deliver().
+    pair<const Message*, const Message*> inboxOf(uint32_t id){
+        auto lo = lower_bound(inbox.begin(), inbox.end(), id, [](const Message& m, uint32_t v){ return m.to < v; });
+        auto hi = upper_bound(lo, inbox.end(), id, [](uint32_t v, const Message& m){ return v < m.to; });
+        return {inbox.data() + (lo - inbox.begin()), inbox.data() + (hi - inbox.begin())};
+    }
+    
+    BusMetrics metrics(){
+        BusMetrics m;
+        m.queues = ringCount.load(memory_order_acquire);
+        for(size_t i = 0; i < m.queues; i++){
+            SpscRing<Message>* q = rings[i].get();
+            size_t depth = q->depth();
+            m.sent += q->pushed();
+            m.backpressure += q->rejectedFull();
+            m.droppedMuted += q->droppedMuted();
+            m.queueDepth += depth;
+            m.maxQueueDepth = max(m.maxQueueDepth, depth);
+        }
+        m.delivered = delivered;
+        m.droppedRange = outOfRange;
+        m.droppedUnknown = unknownRobot;
+        m.droppedNoQueue = noQueue.load(memory_order_relaxed);
+        return m;
+    }
+};
+
 class Talkable{
     public:
     virtual void talk() = 0;
+    virtual bool talk(MessageBus& bus, const Message& msg) = 0;
+    virtual bool enabled() = 0;
+    virtual ~Talkable() = default;
 };
 
 class NormalTalk : public Talkable{
@@ -12,6 +327,14 @@ class NormalTalk : public Talkable{
     void talk() override{
         cout<<"robot can talk normally"<<endl;
     }
+    
+    bool talk(MessageBus& bus, const Message& msg) override{
+        return bus.send(msg);
+    }
+    
+    bool enabled() override{
+        return true;
+    }
 };
 
 class NoTalk : public Talkable{
@@ -19,11 +342,23 @@ class NoTalk : public Talkable{
     void talk() override{
         cout<<"robot can not talk"<<endl;
     }
+    
+    bool talk(MessageBus& bus, const Message&) override{
+        bus.mute();
+        return false;
+    }
+    
+    bool enabled() override{
+        return false;
+    }
 };
 
 class Walkable{
     public:
     virtual void walk() = 0;
+    virtual void walk(KinematicBatch& batch, float dt) = 0;
+    virtual bool enabled() = 0;
+    virtual ~Walkable() = default;
 };
 
 class NormalWalk : public Walkable{
@@ -31,6 +366,16 @@ class NormalWalk : public Walkable{
     void walk() override{
         cout<<"robot can walk normally"<<endl;
     }
+    
+    void walk(KinematicBatch& batch, float dt) override{
+        IntegrateFn integrate = integrateKernel();
+        integrate(batch.x.data(), batch.vx.data(), batch.active(), dt);
+        integrate(batch.y.data(), batch.vy.data(), batch.active(), dt);
+    }
+    
+    bool enabled() override{
+        return true;
+    }
 };
 
 class NoWalk : public Walkable{
@@ -38,11 +383,20 @@ class NoWalk : public Walkable{
     void walk() override{
         cout<<"robot can not walk"<<endl;
     }
+    
+    void walk(KinematicBatch&, float) override{}
+    
+    bool enabled() override{
+        return false;
+    }
 };
 
 class Flyable{
     public:
     virtual void fly() = 0;
+    virtual void fly(KinematicBatch& batch, float dt) = 0;
+    virtual bool enabled() = 0;
+    virtual ~Flyable() = default;
 };
 
 class NormalFly : public Flyable{
@@ -50,6 +404,14 @@ class NormalFly : public Flyable{
     void fly() override{
         cout<<"robot can fly normally"<<endl;
     }
+    
+    void fly(KinematicBatch& batch, float dt) override{
+        integrateKernel()(batch.z.data(), batch.vz.data(), batch.active(), dt);
+    }
+    
+    bool enabled() override{
+        return true;
+    }
 };
 
 class NoWFly : public Flyable{
@@ -57,13 +419,190 @@ class NoWFly : public Flyable{
     void fly() override{
         cout<<"robot can not fly"<<endl;
     }
+    
+    void fly(KinematicBatch&, float) override{}
+    
+    bool enabled() override{
+        return false;
+    }
+};
+
+// Epoch based reclamation for strategies swapped out of a live robot. Reader
+// threads wrap a whole batch of work (a tick, not a single call) in an
+// EpochGuard; a retired object is only freed once every thread that could
+// still see it has left the epoch it was retired in.
+class EpochDomain{
+    private:
+    static const int MAX_THREADS = 64;
+    
+    struct alignas(64) Slot{
+        atomic<uint64_t> epoch{0};      // 0 means the thread is not reading
+        atomic<bool> taken{false};
+    };
+    
+    // Slots this thread holds in every domain it has read from. They are
+    // handed back when the thread exits, if the domain is still alive.
+    struct ThreadSlots{
+        vector<pair<uint64_t, int>> held;     // domain serial, slot
+        
+        ~ThreadSlots(){
+            lock_guard<mutex> guard(liveLock());
+            for(auto& h:held){
+                auto it = live().find(h.first);
+                if(it != live().end()){
+                    it->second->slots[h.second].taken.store(false, memory_order_release);
+                }
+            }
+        }
+    };
+    
+    Slot slots[MAX_THREADS];
+    atomic<int> overflow{0};            // readers that found every slot taken
+    atomic<uint64_t> global{1};
+    mutex retireLock;
+    vector<pair<uint64_t, function<void()>>> retired;
+    uint64_t serial;
+    
+    static atomic<uint64_t>& serials(){
+        static atomic<uint64_t> next{1};
+        return next;
+    }
+    
+    static mutex& liveLock(){
+        static mutex* lock = new mutex();
+        return *lock;
+    }
+    
+    static unordered_map<uint64_t, EpochDomain*>& live(){
+        static auto* domains = new unordered_map<uint64_t, EpochDomain*>();
+        return *domains;
+    }
+    
+    // This thread's slot, claimed on first use. -1 when all MAX_THREADS are
+    // held by live threads; the next enter() tries again.
+    int slot(){
+        thread_local ThreadSlots mine;
+        for(auto& h:mine.held){
+            if(h.first == serial) return h.second;
+        }
+        for(int i = 0; i < MAX_THREADS; i++){
+            bool expected = false;
+            if(!slots[i].taken.load(memory_order_relaxed) && slots[i].taken.compare_exchange_strong(expected, true)){
+                mine.held.push_back({serial, i});
+                return i;
+            }
+        }
+        return -1;
+    }
+    
+    public:
+    EpochDomain(){
+        serial = serials().fetch_add(1);
+        lock_guard<mutex> guard(liveLock());
+        live()[serial] = this;
+    }
+    
+    ~EpochDomain(){
+        {
+            lock_guard<mutex> guard(liveLock());
+            live().erase(serial);
+        }
+        for(auto& r:retired) r.second();
+    }
+    
+    // Returns the slot to pass to exit(). A thread without a slot reads as an
+    // overflow reader; while any is inside, reclaim() frees nothing.
+    int enter(){
+        int i = slot();
+        if(i < 0){
+            overflow.fetch_add(1, memory_order_seq_cst);
+        }else{
+            slots[i].epoch.store(global.load(memory_order_acquire), memory_order_seq_cst);
+        }
+        atomic_thread_fence(memory_order_seq_cst);
+        return i;
+    }
+    
+    void exit(int i){
+        if(i < 0){
+            overflow.fetch_sub(1, memory_order_release);
+        }else{
+            slots[i].epoch.store(0, memory_order_release);
+        }
+    }
+    
+    void retire(function<void()> free){
+        uint64_t e = global.fetch_add(1, memory_order_seq_cst);
+        lock_guard<mutex> guard(retireLock);
+        retired.push_back({e, move(free)});
+    }
+    
+    // Frees everything no reader can still reference, returns how many.
+    size_t reclaim(){
+        uint64_t oldest = UINT64_MAX;
+        if(overflow.load(memory_order_seq_cst) > 0){
+            oldest = 0;
+        }
+        for(int i = 0; i < MAX_THREADS; i++){
+            uint64_t e = slots[i].epoch.load(memory_order_seq_cst);
+            if(e != 0) oldest = min(oldest, e);
+        }
+        vector<function<void()>> ready;
+        {
+            lock_guard<mutex> guard(retireLock);
+            auto keep = partition(retired.begin(), retired.end(), [&](const pair<uint64_t, function<void()>>& r){ return r.first >= oldest; });
+            for(auto it = keep; it != retired.end(); it++) ready.push_back(move(it->second));
+            retired.erase(keep, retired.end());
+        }
+        for(auto& f:ready) f();
+        return ready.size();
+    }
+    
+    size_t pending(){
+        lock_guard<mutex> guard(retireLock);
+        return retired.size();
+    }
 };
 
+class EpochGuard{
+    private:
+    EpochDomain* domain;
+    int slot = -1;
+    
+    public:
+    // A null domain makes the guard a no-op.
+    EpochGuard(EpochDomain* domain){
+        this->domain = domain;
+        if(domain) slot = domain->enter();
+    }
+    
+    ~EpochGuard(){
+        if(domain) domain->exit(slot);
+    }
+};
+
+enum RobotKind : uint8_t { DRONE = 0, WORKER = 1 };
+
+enum Capability : uint8_t { CAN_TALK = 1, CAN_WALK = 2, CAN_FLY = 4 };
+
+// Strategies can be swapped while other threads are using the robot. Each
+// strategy pointer is an atomic that readers load once with acquire ordering,
+// so there is no lock or read-modify-write on the hot path. The old strategy
+// is retired to an EpochDomain when the caller owns it, otherwise left alone.
 class Robot{
     private:
-    Talkable* t;
-    Walkable* w;
-    Flyable* f;
+    atomic<Talkable*> t;
+    atomic<Walkable*> w;
+    atomic<Flyable*> f;
+    uint32_t id = UINT32_MAX;
+    
+    template<class S>
+    static void replace(atomic<S*>& slot, S* next, EpochDomain* reclaim){
+        S* old = slot.exchange(next, memory_order_seq_cst);
+        if(reclaim && old != next){
+            reclaim->retire([old]{ delete old; });
+        }
+    }
     
     public:
     
@@ -74,17 +613,57 @@ class Robot{
     }
     
     void talk(){
-        t->talk();
+        METRIC_COUNT("robot_talk_total", 1);
+        talker()->talk();
+    }
+    bool talk(MessageBus& bus, uint32_t to, uint64_t payload){
+        METRIC_COUNT("robot_messages_sent_total", 1);
+        return talker()->talk(bus, {id, to, payload});
     }
     void walk(){
-        w->walk();
+        METRIC_COUNT("robot_walk_total", 1);
+        walker()->walk();
     }
     void fly(){
-        f->fly();
+        METRIC_COUNT("robot_fly_total", 1);
+        flyer()->fly();
+    }
+    
+    Talkable* talker(){
+        return t.load(memory_order_acquire);
+    }
+    Walkable* walker(){
+        return w.load(memory_order_acquire);
+    }
+    Flyable* flyer(){
+        return f.load(memory_order_acquire);
+    }
+    
+    void setTalkable(Talkable* next, EpochDomain* reclaim = nullptr){
+        replace(t, next, reclaim);
+    }
+    void setWalkable(Walkable* next, EpochDomain* reclaim = nullptr){
+        replace(w, next, reclaim);
+    }
+    void setFlyable(Flyable* next, EpochDomain* reclaim = nullptr){
+        replace(f, next, reclaim);
+    }
+    
+    uint32_t fleetId(){
+        return id;
+    }
+    void attach(uint32_t id){
+        this->id = id;
+    }
+    
+    uint8_t capabilities(){
+        return (talker()->enabled() ? CAN_TALK : 0) | (walker()->enabled() ? CAN_WALK : 0) | (flyer()->enabled() ? CAN_FLY : 0);
     }
     
     virtual void projection() = 0;
+    virtual RobotKind kind() = 0;
     
+    virtual ~Robot() = default;
 };
 
 class Drone : public Robot{
@@ -96,6 +675,10 @@ class Drone : public Robot{
         cout<<"Hello i am Drone"<<endl;
     }
     
+    RobotKind kind() override{
+        return DRONE;
+    }
+    
 };
 
 class Worker : public Robot {
@@ -105,10 +688,787 @@ class Worker : public Robot {
     void projection() override{
         cout<<"Hello i am Worker"<<endl;
     }
+    
+    RobotKind kind() override{
+        return WORKER;
+    }
+};
+
+// Strategies are stateless, so robots rebuilt from a snapshot or a log share
+// one instance of each. These are never retired.
+Talkable* sharedTalk(bool enabled){
+    static NormalTalk normalTalk;   static NoTalk noTalk;
+    return enabled ? (Talkable*)&normalTalk : &noTalk;
+}
+Walkable* sharedWalk(bool enabled){
+    static NormalWalk normalWalk;   static NoWalk noWalk;
+    return enabled ? (Walkable*)&normalWalk : &noWalk;
+}
+Flyable* sharedFly(bool enabled){
+    static NormalFly normalFly;     static NoWFly noFly;
+    return enabled ? (Flyable*)&normalFly : &noFly;
+}
+
+// Rebuilds a robot from its kind and capability bits. With mem set the robot
+// is constructed in place instead of on the heap.
+Robot* makeRobot(RobotKind kind, uint8_t caps, void* mem = nullptr){
+    Talkable* t = sharedTalk(caps & CAN_TALK);
+    Walkable* w = sharedWalk(caps & CAN_WALK);
+    Flyable* f = sharedFly(caps & CAN_FLY);
+    if(kind == DRONE){
+        return mem ? new(mem) Drone(t, w, f) : new Drone(t, w, f);
+    }
+    return mem ? new(mem) Worker(t, w, f) : new Worker(t, w, f);
+}
+
+static const size_t ROBOT_SLOT = max(sizeof(Drone), sizeof(Worker));
+
+// Per-tick event log. Every state change that goes through RobotFleet is
+// appended here, so replaying the log into an empty fleet reproduces the run
+// bit for bit. Records are fixed-size and written straight to the stream.
+enum EventType : uint8_t { EV_SPAWN = 1, EV_VELOCITY = 2, EV_TICK = 3, EV_SWAP = 4, EV_SLEEP = 5, EV_WAKE = 6 };
+
+struct EventRecord{
+    uint8_t type;
+    uint8_t profile;        // kind << 3 | capabilities, spawn and swap only
+    uint16_t reserved;
+    uint32_t id;
+    float v[6];
+};
+
+class EventLog{
+    private:
+    ostream* out;
+    uint64_t count = 0;
+    
+    public:
+    EventLog(ostream* out){
+        this->out = out;
+    }
+    
+    void append(const EventRecord& ev){
+        out->write((const char*)&ev, sizeof(ev));
+        count++;
+    }
+    
+    uint64_t size(){
+        return count;
+    }
+};
+
+// Snapshot layout, every section starts on a 64 byte boundary so a reader can
+// mmap the file and use the columns in place:
+//   SnapshotHeader
+//   per archetype: ArchetypeHeader, ids[count], profile[count],
+//                  x[count], y[count], z[count], vx[count], vy[count], vz[count]
+struct SnapshotHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t archetypeCount;
+    uint64_t robotCount;
+    uint64_t tick;
+    char pad[32];
+};
+
+struct ArchetypeHeader{
+    uint8_t caps;           // walk/fly bits shared by the whole archetype
+    uint8_t pad[7];
+    uint64_t count;
+    uint64_t awake;         // version 2: rows [0, awake) are awake
+    char reserved[40];
 };
 
-int main() 
+static const char SNAPSHOT_MAGIC[8] = {'R','B','S','N','A','P','0','1'};
+
+static void writeColumn(ostream& out, const void* data, size_t bytes){
+    static const char zeros[64] = {};
+    out.write((const char*)data, bytes);
+    out.write(zeros, (64 - bytes % 64) % 64);
+}
+
+// Bytes between the read position and the end, UINT64_MAX if the stream
+// cannot seek.
+static uint64_t bytesLeft(istream& in){
+    streampos here = in.tellg();
+    if(here < 0 || !in.seekg(0, ios::end)){
+        in.clear();
+        return UINT64_MAX;
+    }
+    streampos end = in.tellg();
+    in.seekg(here);
+    return end - here;
+}
+
+static bool readColumn(istream& in, void* data, size_t bytes){
+    char pad[64];
+    in.read((char*)data, bytes);
+    in.read(pad, (64 - bytes % 64) % 64);
+    return (bool)in;
+}
+
+// Groups robots into archetypes by the concrete types of their walk/fly strategies,
+// so one tick is a single batched walk() and fly() call per archetype instead of
+// one virtual call per robot.
+class RobotFleet{
+    private:
+    struct Archetype{
+        type_index walkType;
+        type_index flyType;
+        Walkable* w;                    // shared instances, never retired; nullptr
+        Flyable* f;                     // for a strategy type with no shared one
+        KinematicBatch state;
+        vector<uint32_t> ids;
+    };
+    
+    struct Location{
+        uint32_t archetype;
+        uint32_t row;
+    };
+    
+    static constexpr uint64_t AWAKE = 0;
+    static constexpr uint64_t UNTIL_WOKEN = UINT64_MAX;
+    static constexpr size_t WHEEL_SLOTS = 256;
+    
+    struct Timer{
+        uint32_t id;
+        uint64_t due;
+    };
+    
+    vector<Archetype> archetypes;
+    vector<Robot*> robots;
+    vector<Location> where;
+    vector<uint64_t> wakeAt;            // AWAKE, UNTIL_WOKEN or the tick a timer wakes the robot
+    vector<Timer> wheel[WHEEL_SLOTS];   // timers by due tick modulo WHEEL_SLOTS
+    vector<unique_ptr<Robot>> owned;    // robots rebuilt from a log
+    vector<uint32_t> swapped;           // robots whose strategies changed since the last tick
+    mutex swapLock;
+    unique_ptr<char[]> arena;           // robots rebuilt from a snapshot, one slot per id
+    size_t arenaSlots = 0;
+    uint64_t ticks = 0;
+    EventLog* log = nullptr;
+    EpochDomain* epochs = nullptr;      // where swapped-out strategies are retired
+    
+    // The shared instance of the same type as s, or nullptr if s is of a type
+    // the fleet has no shared instance of.
+    static Walkable* sharedLike(Walkable* s){
+        Walkable* shared = sharedWalk(s->enabled());
+        return typeid(*s) == typeid(*shared) ? shared : nullptr;
+    }
+    static Flyable* sharedLike(Flyable* s){
+        Flyable* shared = sharedFly(s->enabled());
+        return typeid(*s) == typeid(*shared) ? shared : nullptr;
+    }
+    
+    // Archetypes are keyed by the strategies' actual types. The built-in
+    // kernels are stateless, so such an archetype steps its rows with the
+    // shared strategy instead of borrowing the first robot's, which a hot swap
+    // may retire and free while the archetype lives on. Any other strategy
+    // type may keep state, so its rows are stepped one by one with each
+    // robot's own strategy instead (see stepEach).
+    uint32_t archetypeFor(Robot* rb){
+        type_index wt = typeid(*rb->walker());
+        type_index ft = typeid(*rb->flyer());
+        for(uint32_t i = 0; i < archetypes.size(); i++){
+            if(archetypes[i].walkType == wt && archetypes[i].flyType == ft){
+                return i;
+            }
+        }
+        archetypes.push_back({wt, ft, sharedLike(rb->walker()), sharedLike(rb->flyer()), KinematicBatch(), {}});
+        archetypes.back().state.awake = 0;
+        return archetypes.size() - 1;
+    }
+    
+    static array<vector<float>*, 6> columns(KinematicBatch& s){
+        return {&s.x, &s.y, &s.z, &s.vx, &s.vy, &s.vz};
+    }
+    
+    // Slow path for an archetype without a shared walk or fly strategy: every
+    // awake row is copied into a one-row batch and stepped by its robot's own
+    // strategy. Runs inside the tick's epoch, like the batched path.
+    void stepEach(Archetype& a, float dt){
+        KinematicBatch one;
+        auto rowCols = columns(one);
+        auto cols = columns(a.state);
+        for(vector<float>* col : rowCols){
+            col->resize(1);
+        }
+        for(size_t r = 0; r < a.state.active(); r++){
+            for(int c = 0; c < 6; c++){
+                (*rowCols[c])[0] = (*cols[c])[r];
+            }
+            Robot* rb = robots[a.ids[r]];
+            if(!a.w) rb->walker()->walk(one, dt);
+            if(!a.f) rb->flyer()->fly(one, dt);
+            for(int c = 0; c < 6; c++){
+                (*cols[c])[r] = (*rowCols[c])[0];
+            }
+        }
+    }
+    
+    void swapRows(uint32_t a, uint32_t r1, uint32_t r2){
+        if(r1 == r2) return;
+        Archetype& arch = archetypes[a];
+        for(vector<float>* col : columns(arch.state)){
+            swap((*col)[r1], (*col)[r2]);
+        }
+        swap(arch.ids[r1], arch.ids[r2]);
+        where[arch.ids[r1]].row = r1;
+        where[arch.ids[r2]].row = r2;
+    }
+    
+    // Appends a row, into the awake prefix if the robot is awake.
+    void addRow(uint32_t a, uint32_t id, const array<float,6>& values){
+        Archetype& arch = archetypes[a];
+        auto cols = columns(arch.state);
+        for(int c = 0; c < 6; c++){
+            cols[c]->push_back(values[c]);
+        }
+        arch.ids.push_back(id);
+        where[id] = {a, (uint32_t)arch.ids.size() - 1};
+        if(wakeAt[id] == AWAKE){
+            swapRows(a, where[id].row, arch.state.awake);
+            arch.state.awake++;
+        }
+    }
+    
+    // Removes a row and returns its values. Swap-remove keeps both the awake
+    // prefix and the sleeping rows dense.
+    array<float,6> removeRow(uint32_t id){
+        Location loc = where[id];
+        Archetype& arch = archetypes[loc.archetype];
+        KinematicBatch& s = arch.state;
+        if(loc.row < s.awake){
+            swapRows(loc.archetype, loc.row, s.awake - 1);
+            s.awake--;
+        }
+        swapRows(loc.archetype, where[id].row, s.size() - 1);
+        array<float,6> values;
+        auto cols = columns(s);
+        for(int c = 0; c < 6; c++){
+            values[c] = cols[c]->back();
+            cols[c]->pop_back();
+        }
+        arch.ids.pop_back();
+        return values;
+    }
+    
+    // Moves a robot's row in or out of its archetype's awake prefix.
+    void setAwake(uint32_t id, bool awake){
+        Location loc = where[id];
+        KinematicBatch& s = archetypes[loc.archetype].state;
+        if(awake && loc.row >= s.awake){
+            swapRows(loc.archetype, loc.row, s.awake);
+            s.awake++;
+        }else if(!awake && loc.row < s.awake){
+            swapRows(loc.archetype, loc.row, s.awake - 1);
+            s.awake--;
+        }
+    }
+    
+    void putToSleep(uint32_t id, uint64_t until){
+        wakeAt[id] = until;
+        setAwake(id, false);
+        if(until != UNTIL_WOKEN){
+            wheel[until % WHEEL_SLOTS].push_back({id, until});
+        }
+    }
+    
+    // Wakes the robots whose timer is due this tick. Only the one wheel slot
+    // is visited; timers for later rounds stay, cancelled ones are dropped.
+    void fireTimers(){
+        vector<Timer>& slot = wheel[ticks % WHEEL_SLOTS];
+        for(size_t i = 0; i < slot.size();){
+            Timer t = slot[i];
+            if(t.due > ticks){
+                i++;
+                continue;
+            }
+            if(wakeAt[t.id] == t.due){
+                wakeAt[t.id] = AWAKE;
+                setAwake(t.id, true);
+            }
+            slot[i] = slot.back();
+            slot.pop_back();
+        }
+    }
+    
+    // Robots with nothing to integrate go to sleep until something wakes
+    // them. Their state would not change anyway, so this never changes the
+    // simulation, only what a tick has to visit.
+    void sleepIdle(){
+        for(uint32_t a = 0; a < archetypes.size(); a++){
+            Archetype& arch = archetypes[a];
+            KinematicBatch& s = arch.state;
+            for(size_t r = s.awake; r-- > 0;){
+                uint32_t id = arch.ids[r];
+                bool walks = arch.w ? arch.w->enabled() : robots[id]->walker()->enabled();
+                bool flies = arch.f ? arch.f->enabled() : robots[id]->flyer()->enabled();
+                bool moving = (walks && (s.vx[r] != 0 || s.vy[r] != 0)) || (flies && s.vz[r] != 0);
+                if(!moving){
+                    wakeAt[id] = UNTIL_WOKEN;
+                    swapRows(a, r, s.awake - 1);
+                    s.awake--;
+                }
+            }
+        }
+    }
+    
+    // Moves a robot's row to the archetype matching its current strategies.
+    void rehome(uint32_t id){
+        Robot* rb = robots[id];
+        uint32_t to = archetypeFor(rb);
+        if(to == where[id].archetype){
+            return;
+        }
+        addRow(to, id, removeRow(id));
+    }
+    
+    // Runs on the tick thread, so the row move and the log record happen
+    // where the rest of the fleet state is owned. The record carries the
+    // robot's strategies as of this tick, which is all replay needs: rows
+    // only move at a tick.
+    void applySwaps(){
+        lock_guard<mutex> guard(swapLock);
+        for(uint32_t id : swapped){
+            rehome(id);
+            // New strategies may move a robot that was idle before.
+            if(wakeAt[id] != AWAKE){
+                wakeAt[id] = AWAKE;
+                setAwake(id, true);
+            }
+            if(log){
+                Robot* rb = robots[id];
+                log->append({EV_SWAP, (uint8_t)(rb->kind() << 3 | rb->capabilities()), 0, id, {0, 0, 0, 0, 0, 0}});
+            }
+        }
+        swapped.clear();
+    }
+    
+    // Runs on the swapping thread. spawn() may be growing the robots on the
+    // tick thread, so the robot is only looked up under swapLock, and the
+    // swap is just queued for applySwaps().
+    template<class Set> void queueSwap(uint32_t id, Set set){
+        lock_guard<mutex> guard(swapLock);
+        set(robots[id]);
+        swapped.push_back(id);
+    }
+    
+    public:
+    void record(EventLog* log){
+        this->log = log;
+    }
+    
+    // The domain strategies of this fleet's robots are retired to. spawn() and
+    // tick() read the robots' strategies inside it, so a strategy swapped out
+    // on another thread is not freed under them.
+    void protect(EpochDomain* domain){
+        epochs = domain;
+    }
+    
+    uint32_t spawn(Robot* rb, float x, float y, float z, float vx, float vy, float vz){
+        EpochGuard guard(epochs);
+        uint32_t id = robots.size();
+        uint32_t a = archetypeFor(rb);
+        where.push_back({a, 0});
+        wakeAt.push_back(AWAKE);
+        addRow(a, id, {x, y, z, vx, vy, vz});
+        {
+            lock_guard<mutex> lock(swapLock);
+            robots.push_back(rb);
+        }
+        rb->attach(id);
+        if(log){
+            log->append({EV_SPAWN, (uint8_t)(rb->kind() << 3 | rb->capabilities()), 0, id, {x, y, z, vx, vy, vz}});
+        }
+        return id;
+    }
+    
+    // New work: wakes the robot if it was asleep.
+    void setVelocity(uint32_t id, float vx, float vy, float vz){
+        if(wakeAt[id] != AWAKE){
+            wakeAt[id] = AWAKE;
+            setAwake(id, true);
+        }
+        Location loc = where[id];
+        KinematicBatch& s = archetypes[loc.archetype].state;
+        s.vx[loc.row] = vx;
+        s.vy[loc.row] = vy;
+        s.vz[loc.row] = vz;
+        if(log){
+            log->append({EV_VELOCITY, 0, 0, id, {vx, vy, vz, 0, 0, 0}});
+        }
+    }
+    
+    // Hot-swap strategies of a live robot. The robot sees the new strategy at
+    // once; its kinematic row moves to the matching archetype, and the swap is
+    // recorded in the log, at the next tick.
+    void swapTalkable(uint32_t id, Talkable* next, EpochDomain* reclaim = nullptr){
+        queueSwap(id, [&](Robot* rb){ rb->setTalkable(next, reclaim); });
+    }
+    void swapWalkable(uint32_t id, Walkable* next, EpochDomain* reclaim = nullptr){
+        queueSwap(id, [&](Robot* rb){ rb->setWalkable(next, reclaim); });
+    }
+    void swapFlyable(uint32_t id, Flyable* next, EpochDomain* reclaim = nullptr){
+        queueSwap(id, [&](Robot* rb){ rb->setFlyable(next, reclaim); });
+    }
+    
+    // Puts a robot to sleep for the next n ticks, or until woken if n is 0.
+    // A sleeping robot keeps its position; a message, wake() or
+    // setVelocity() wakes it early.
+    void sleep(uint32_t id, uint32_t n = 0){
+        putToSleep(id, n ? ticks + n : UNTIL_WOKEN);
+        if(log){
+            EventRecord ev = {EV_SLEEP, 0, 0, id, {0, 0, 0, 0, 0, 0}};
+            memcpy(&ev.v[0], &n, sizeof(n));
+            log->append(ev);
+        }
+    }
+    
+    void wake(uint32_t id){
+        if(wakeAt[id] == AWAKE){
+            return;
+        }
+        wakeAt[id] = AWAKE;
+        setAwake(id, true);
+        if(log){
+            log->append({EV_WAKE, 0, 0, id, {0, 0, 0, 0, 0, 0}});
+        }
+    }
+    
+    bool asleep(uint32_t id){
+        return wakeAt[id] != AWAKE;
+    }
+    
+    size_t awakeCount(){
+        size_t n = 0;
+        for(auto& a:archetypes){
+            n += a.state.awake;
+        }
+        return n;
+    }
+    
+    // Cost is proportional to the awake robots plus the timers due this tick.
+    void tick(float dt){
+        METRIC_TIMER("robot_fleet_tick_ns");
+        EpochGuard guard(epochs);
+        applySwaps();
+        fireTimers();
+        size_t stepped = 0;
+        for(auto& a:archetypes){
+            if(a.w) a.w->walk(a.state, dt);
+            if(a.f) a.f->fly(a.state, dt);
+            if(!a.w || !a.f) stepEach(a, dt);
+            stepped += a.state.awake;
+        }
+        METRIC_COUNT("robot_fleet_robot_steps_total", stepped);
+        sleepIdle();
+        ticks++;
+        if(log){
+            log->append({EV_TICK, 0, 0, 0, {dt, 0, 0, 0, 0, 0}});
+        }
+    }
+    
+    Robot* robot(uint32_t id){
+        return robots[id];
+    }
+    
+    array<float,3> position(uint32_t id){
+        Location loc = where[id];
+        KinematicBatch& s = archetypes[loc.archetype].state;
+        return {s.x[loc.row], s.y[loc.row], s.z[loc.row]};
+    }
+    
+    size_t size(){
+        return robots.size();
+    }
+    
+    size_t archetypeCount(){
+        return archetypes.size();
+    }
+    
+    uint64_t tickCount(){
+        return ticks;
+    }
+    
+    void clear(){
+        if(arena){
+            for(Robot* rb : robots){
+                if(rb && (char*)rb >= arena.get() && (char*)rb < arena.get() + arenaSlots * ROBOT_SLOT){
+                    rb->~Robot();
+                }
+            }
+            arena.reset();
+            arenaSlots = 0;
+        }
+        archetypes.clear();
+        robots.clear();
+        where.clear();
+        wakeAt.clear();
+        for(auto& slot:wheel){
+            slot.clear();
+        }
+        owned.clear();
+        ticks = 0;
+    }
+    
+    ~RobotFleet(){
+        clear();
+    }
+    
+    void saveSnapshot(ostream& out){
+        EpochGuard guard(epochs);
+        applySwaps();
+        SnapshotHeader header = {};
+        memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = 2;
+        header.archetypeCount = archetypes.size();
+        header.robotCount = robots.size();
+        header.tick = ticks;
+        out.write((const char*)&header, sizeof(header));
+        
+        vector<uint8_t> profile;
+        vector<uint64_t> wake;
+        for(auto& a:archetypes){
+            size_t n = a.ids.size();
+            ArchetypeHeader ah = {};
+            // An archetype without a shared strategy takes its first robot's.
+            Robot* first = n ? robots[a.ids[0]] : nullptr;
+            bool walks = a.w ? a.w->enabled() : first && first->walker()->enabled();
+            bool flies = a.f ? a.f->enabled() : first && first->flyer()->enabled();
+            ah.caps = (walks ? CAN_WALK : 0) | (flies ? CAN_FLY : 0);
+            ah.count = n;
+            ah.awake = a.state.awake;
+            out.write((const char*)&ah, sizeof(ah));
+            
+            profile.resize(n);
+            for(size_t i = 0; i < n; i++){
+                Robot* rb = robots[a.ids[i]];
+                profile[i] = rb->kind() << 3 | rb->capabilities();
+            }
+            writeColumn(out, a.ids.data(), n * sizeof(uint32_t));
+            writeColumn(out, profile.data(), n);
+            const KinematicBatch& s = a.state;
+            for(const vector<float>* col : {&s.x, &s.y, &s.z, &s.vx, &s.vy, &s.vz}){
+                writeColumn(out, col->data(), n * sizeof(float));
+            }
+            wake.resize(n);
+            for(size_t i = 0; i < n; i++){
+                wake[i] = wakeAt[a.ids[i]];
+            }
+            writeColumn(out, wake.data(), n * sizeof(uint64_t));
+        }
+    }
+    
+    // Replaces the whole fleet with the one stored in the snapshot.
+    // Version 1 snapshots have no sleep state; their robots start awake.
+    // Counts and ids come from the file, so every one is checked against
+    // the size of the stream before it sizes an allocation or picks a slot.
+    bool loadSnapshot(istream& in){
+        uint64_t left = bytesLeft(in);
+        if(left == UINT64_MAX){
+            stringstream buffered;      // not seekable, buffer it to learn its size
+            buffered<<in.rdbuf();
+            return loadSnapshot(buffered);
+        }
+        SnapshotHeader header;
+        if(!in.read((char*)&header, sizeof(header)) || memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version < 1 || header.version > 2){
+            cout<<"Error : not a robot snapshot"<<endl;
+            return false;
+        }
+        left -= sizeof(header);
+        // Smallest possible row: id, profile byte, six floats and a wake tick.
+        size_t rowBytes = sizeof(uint32_t) + 1 + 6 * sizeof(float) + (header.version >= 2 ? sizeof(uint64_t) : 0);
+        if(header.robotCount > UINT32_MAX || header.robotCount > left / rowBytes || header.archetypeCount > left / sizeof(ArchetypeHeader)){
+            cout<<"Error : robot snapshot counts exceed its size"<<endl;
+            return false;
+        }
+        clear();
+        ticks = header.tick;
+        robots.assign(header.robotCount, nullptr);
+        where.resize(header.robotCount);
+        wakeAt.assign(header.robotCount, AWAKE);
+        arena.reset(new char[header.robotCount * ROBOT_SLOT]);
+        arenaSlots = header.robotCount;
+        
+        auto fail = [&](const char* why){
+            cout<<"Error : "<<why<<endl;
+            clear();
+            return false;
+        };
+        
+        vector<uint8_t> profile;
+        vector<uint64_t> wake;
+        vector<bool> seen(header.robotCount, false);
+        uint64_t loaded = 0;
+        for(uint32_t ai = 0; ai < header.archetypeCount; ai++){
+            ArchetypeHeader ah;
+            if(!in.read((char*)&ah, sizeof(ah))){
+                return fail("truncated robot snapshot");
+            }
+            if(ah.count > header.robotCount - loaded){
+                return fail("robot snapshot has more rows than robots");
+            }
+            size_t n = ah.count;
+            loaded += n;
+            archetypes.push_back({typeid(*sharedWalk(ah.caps & CAN_WALK)), typeid(*sharedFly(ah.caps & CAN_FLY)), sharedWalk(ah.caps & CAN_WALK), sharedFly(ah.caps & CAN_FLY), KinematicBatch(), {}});
+            
+            Archetype& a = archetypes.back();
+            KinematicBatch& s = a.state;
+            a.ids.resize(n);
+            profile.resize(n);
+            bool ok = readColumn(in, a.ids.data(), n * sizeof(uint32_t)) && readColumn(in, profile.data(), n);
+            for(vector<float>* col : {&s.x, &s.y, &s.z, &s.vx, &s.vy, &s.vz}){
+                col->resize(n);
+                ok = ok && readColumn(in, col->data(), n * sizeof(float));
+            }
+            wake.assign(n, AWAKE);
+            s.awake = n;
+            if(header.version >= 2){
+                ok = ok && readColumn(in, wake.data(), n * sizeof(uint64_t)) && ah.awake <= n;
+                s.awake = ah.awake;
+            }
+            if(!ok){
+                return fail("truncated robot snapshot");
+            }
+            for(size_t i = 0; i < n; i++){
+                uint32_t id = a.ids[i];
+                if(id >= header.robotCount || seen[id]){
+                    return fail("bad robot id in snapshot");
+                }
+                if((i < s.awake) != (wake[i] == AWAKE)){
+                    return fail("bad sleep state in snapshot");
+                }
+                seen[id] = true;
+                robots[id] = makeRobot((RobotKind)(profile[i] >> 3), profile[i] & 7, arena.get() + (size_t)id * ROBOT_SLOT);
+                robots[id]->attach(id);
+                where[id] = {ai, (uint32_t)i};
+                wakeAt[id] = wake[i];
+                if(wake[i] != AWAKE && wake[i] != UNTIL_WOKEN){
+                    wheel[wake[i] % WHEEL_SLOTS].push_back({id, wake[i]});
+                }
+            }
+        }
+        if(loaded != header.robotCount){
+            return fail("robot snapshot is missing robots");
+        }
+        return true;
+    }
+    
+    // Applies a recorded event log on top of the current fleet state.
+    // Robot ids and kinds come from the file, so each is checked before it
+    // indexes the fleet; replay stops at the first bad event.
+    uint64_t replay(istream& in){
+        EventRecord ev;
+        uint64_t applied = 0;
+        while(in.read((char*)&ev, sizeof(ev))){
+            bool byId = ev.type == EV_VELOCITY || ev.type == EV_SWAP || ev.type == EV_SLEEP || ev.type == EV_WAKE;
+            if(byId && ev.id >= robots.size()){
+                cout<<"Error : unknown robot "<<ev.id<<" in robot log"<<endl;
+                break;
+            }
+            if(ev.type == EV_SPAWN && (ev.profile >> 3) != DRONE && (ev.profile >> 3) != WORKER){
+                cout<<"Error : unknown robot kind in robot log"<<endl;
+                break;
+            }
+            if(ev.type == EV_SPAWN){
+                Robot* rb = makeRobot((RobotKind)(ev.profile >> 3), ev.profile & 7);
+                owned.emplace_back(rb);
+                spawn(rb, ev.v[0], ev.v[1], ev.v[2], ev.v[3], ev.v[4], ev.v[5]);
+            }else if(ev.type == EV_VELOCITY){
+                setVelocity(ev.id, ev.v[0], ev.v[1], ev.v[2]);
+            }else if(ev.type == EV_SWAP){
+                uint8_t caps = ev.profile & 7;
+                queueSwap(ev.id, [&](Robot* rb){
+                    rb->setTalkable(sharedTalk(caps & CAN_TALK));
+                    rb->setWalkable(sharedWalk(caps & CAN_WALK));
+                    rb->setFlyable(sharedFly(caps & CAN_FLY));
+                });
+            }else if(ev.type == EV_SLEEP){
+                uint32_t n;
+                memcpy(&n, &ev.v[0], sizeof(n));
+                sleep(ev.id, n);
+            }else if(ev.type == EV_WAKE){
+                wake(ev.id);
+            }else if(ev.type == EV_TICK){
+                tick(ev.v[0]);
+            }else{
+                cout<<"Error : unknown event in robot log"<<endl;
+                break;
+            }
+            applied++;
+        }
+        return applied;
+    }
+};
+
+size_t MessageBus::deliver(RobotFleet& fleet){
+    METRIC_TIMER("robot_bus_deliver_ns");
+    inbox.clear();
+    float range2 = range * range;
+    size_t queues = ringCount.load(memory_order_acquire);
+    for(size_t i = 0; i < queues; i++){
+        rings[i]->drain([&](const Message& m){
+            if(m.from >= fleet.size() || m.to >= fleet.size()){
+                unknownRobot++;
+                return;
+            }
+            array<float,3> a = fleet.position(m.from);
+            array<float,3> b = fleet.position(m.to);
+            float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+            if(dx * dx + dy * dy + dz * dz > range2){
+                outOfRange++;
+                return;
+            }
+            inbox.push_back(m);
+        });
+    }
+    stable_sort(inbox.begin(), inbox.end(), [](const Message& a, const Message& b){ return a.to < b.to; });
+    for(const Message& m : inbox){
+        fleet.wake(m.to);
+    }
+    delivered += inbox.size();
+    return inbox.size();
+}
+
+// A walk strategy with state of its own, which the fleet cannot replace with
+// a shared instance.
+class CountingWalk : public NormalWalk{
+    public:
+    int steps = 0;
+    
+    void walk(KinematicBatch& batch, float dt) override{
+        NormalWalk::walk(batch, dt);
+        steps += batch.active();
+    }
+};
+
+// Ticks a large fleet where only a fraction of the robots move. Tick cost
+// should follow the moving robots, not the fleet size.
+void idleBenchmark(size_t count){
+    const int ticks = 200;
+    for(double fraction : {0.01, 0.1, 1.0}){
+        RobotFleet fleet;
+        size_t moving = max<size_t>(1, count * fraction);
+        for(size_t i = 0; i < count; i++){
+            float v = i % (count / moving) == 0 ? 1.0f : 0.0f;
+            fleet.spawn(makeRobot(i % 2 ? WORKER : DRONE, i % 2 ? CAN_WALK : CAN_FLY), i, 0, 0, v, v, v);
+        }
+        fleet.tick(0.016f);
+        auto start = chrono::steady_clock::now();
+        for(int t = 0; t < ticks; t++){
+            fleet.tick(0.016f);
+        }
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / ticks;
+        cout<<count<<" robots, "<<fleet.awakeCount()<<" awake : "<<(long long)ns<<" ns/tick"<<endl;
+    }
+}
+
+int main(int argc, char* argv[]) 
 {
+    if(argc > 1 && string(argv[1]) == "--idle-bench"){
+        idleBenchmark(argc > 2 ? atol(argv[2]) : 1000000);
+        return 0;
+    }
     
     Robot* rb1 =  new Drone(new NoTalk(),new NoWalk(),new NormalFly());
     rb1->projection();
@@ -124,6 +1484,232 @@ int main()
     rb2->talk();
     rb2->fly();
 
+    const char* kernel;
+    integrateKernel(&kernel);
+    cout<<"kinematics kernel : "<<kernel<<endl;
+    
+    // The batch API on its own steps every row.
+    KinematicBatch batch;
+    batch.x = batch.y = batch.z = {0, 0};
+    batch.vx = batch.vy = batch.vz = {1, 2};
+    sharedWalk(true)->walk(batch, 0.5f);
+    sharedFly(true)->fly(batch, 0.5f);
+    cout<<"plain batch row 1 at ("<<batch.x[1]<<", "<<batch.y[1]<<", "<<batch.z[1]<<")"<<endl;
+    
+    RobotFleet fleet;
+    uint32_t drone = fleet.spawn(rb1, 0, 0, 0, 0, 0, 2.5f);
+    uint32_t worker = fleet.spawn(rb2, 0, 0, 0, 1.0f, 0.5f, 0);
+    for(int i = 0; i < 10; i++){
+        fleet.tick(0.1f);
+    }
+    array<float,3> dp = fleet.position(drone);
+    array<float,3> wp = fleet.position(worker);
+    cout<<"drone at ("<<dp[0]<<", "<<dp[1]<<", "<<dp[2]<<")"<<endl;
+    cout<<"worker at ("<<wp[0]<<", "<<wp[1]<<", "<<wp[2]<<")"<<endl;
+    
+    // Record a run, replay it into a fresh fleet and check both snapshots match.
+    stringstream events;
+    EventLog log(&events);
+    RobotFleet recorded;
+    recorded.record(&log);
+    for(int i = 0; i < 100; i++){
+        recorded.spawn(makeRobot(i % 2 ? WORKER : DRONE, i % 2 ? CAN_TALK | CAN_WALK : CAN_FLY), i, 0, 0, 0.5f, 0.25f, 1.0f);
+    }
+    for(int i = 0; i < 50; i++){
+        recorded.setVelocity(i, 0.1f * i, 0, 0.3f);
+        if(i % 10 == 0){
+            recorded.swapFlyable(i, sharedFly(false));
+        }
+        if(i % 7 == 0){
+            recorded.sleep(50 + i, i % 14 ? 5 : 0);
+        }
+        recorded.tick(0.016f);
+    }
+    
+    RobotFleet replayed;
+    replayed.replay(events);
+    stringstream snapA, snapB;
+    recorded.saveSnapshot(snapA);
+    replayed.saveSnapshot(snapB);
+    cout<<"replayed "<<log.size()<<" events, bit-exact : "<<(snapA.str() == snapB.str() ? "yes" : "no")<<endl;
+    
+    RobotFleet restored;
+    restored.loadSnapshot(snapA);
+    stringstream snapC;
+    restored.saveSnapshot(snapC);
+    cout<<"snapshot round trip, bit-exact : "<<(snapA.str() == snapC.str() ? "yes" : "no")<<endl;
+    
+    // Corrupted snapshots are rejected: an id past the robot count, then a
+    // robot count far larger than the file.
+    string bad = snapA.str();
+    uint32_t badId = UINT32_MAX;
+    memcpy(&bad[sizeof(SnapshotHeader) + sizeof(ArchetypeHeader)], &badId, sizeof(badId));
+    stringstream badIds(bad);
+    bad = snapA.str();
+    uint64_t badCount = 1ull << 40;
+    memcpy(&bad[offsetof(SnapshotHeader, robotCount)], &badCount, sizeof(badCount));
+    stringstream badCounts(bad);
+    RobotFleet rejected;
+    bool loadedBad = rejected.loadSnapshot(badIds) || rejected.loadSnapshot(badCounts);
+    cout<<"corrupted snapshots rejected : "<<(loadedBad ? "no" : "yes")<<endl;
+    
+    // Corrupted logs stop at the bad event: a velocity for a robot that was
+    // never spawned, then a spawn of an unknown kind.
+    EventRecord badEvents[2] = {{EV_VELOCITY, 0, 0, 1000000, {1, 0, 0, 0, 0, 0}}, {EV_SPAWN, 31 << 3, 0, 0, {0, 0, 0, 0, 0, 0}}};
+    uint64_t badApplied = 0;
+    for(EventRecord& ev : badEvents){
+        stringstream badLog(string((const char*)&ev, sizeof(ev)));
+        badApplied += rejected.replay(badLog);
+    }
+    cout<<"corrupted logs rejected : "<<(badApplied == 0 && rejected.size() == 0 ? "yes" : "no")<<endl;
+    
+    // Robots talk over the bus: the worker reaches the drone, the drone is mute.
+    MessageBus bus(10.0f);
+    rb2->talk(bus, drone, 42);
+    rb1->talk(bus, worker, 7);
+    unique_ptr<Robot> stray(makeRobot(WORKER, CAN_TALK));   // never spawned, dropped as unknown
+    stray->talk(bus, drone, 9);
+    bus.deliver(fleet);
+    auto in = bus.inboxOf(drone);
+    for(const Message* m = in.first; m != in.second; m++){
+        cout<<"drone got "<<m->payload<<" from robot "<<m->from<<endl;
+    }
+    
+    // Several sender threads hammer the bus while the tick thread keeps delivering.
+    const int senders = 4;
+    const int perSender = 1 << 21;
+    atomic<int> running{senders};
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for(int s = 0; s < senders; s++){
+        threads.emplace_back([&, s]{
+            for(int i = 0; i < perSender; i++){
+                while(!rb2->talk(bus, drone, (uint64_t)s << 32 | i)){
+                    this_thread::yield();
+                }
+            }
+            running--;
+        });
+    }
+    while(running > 0){
+        bus.deliver(fleet);
+    }
+    for(auto& th:threads) th.join();
+    bus.deliver(fleet);
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    
+    BusMetrics bm = bus.metrics();
+    cout<<"bus : sent "<<bm.sent<<", delivered "<<bm.delivered<<", retried on full "<<bm.backpressure
+        <<", muted "<<bm.droppedMuted<<", out of range "<<bm.droppedRange<<", unknown robot "<<bm.droppedUnknown
+        <<", no queue "<<bm.droppedNoQueue<<", queues "<<bm.queues<<", depth "<<bm.queueDepth<<endl;
+    cout<<"bus : "<<(long long)(bm.delivered / secs / 1e6)<<"M messages/sec"<<endl;
+    
+    // Far more short-lived senders than MAX_QUEUES, each also using a second
+    // bus: exited threads hand their rings back, so nothing is dropped.
+    MessageBus side(10.0f, 16);
+    for(int s = 0; s < 300; s++){
+        thread([&]{
+            rb2->talk(bus, drone, 1);
+            rb2->talk(side, drone, 2);
+            rb2->talk(bus, drone, 3);
+        }).join();
+    }
+    bus.deliver(fleet);
+    side.deliver(fleet);
+    bm = bus.metrics();
+    BusMetrics sm = side.metrics();
+    cout<<"300 short-lived senders : no queue "<<bm.droppedNoQueue + sm.droppedNoQueue<<", queues "<<bm.queues<<" + "<<sm.queues<<endl;
+    
+    // The drone loses flight mid-run and keeps its position.
+    fleet.swapFlyable(drone, sharedFly(false));
+    fleet.tick(0.1f);
+    dp = fleet.position(drone);
+    cout<<"drone after losing flight at ("<<dp[0]<<", "<<dp[1]<<", "<<dp[2]<<"), can fly : "<<(rb1->capabilities() & CAN_FLY ? "yes" : "no")<<endl;
+    
+    // Park the worker for a while, then wake it early with a message.
+    fleet.sleep(worker, 1000);
+    fleet.tick(0.1f);
+    cout<<"worker parked : "<<(fleet.asleep(worker) ? "yes" : "no")<<", awake robots : "<<fleet.awakeCount()<<endl;
+    rb1->talk(bus, worker, 1);
+    rb2->talk(bus, worker, 1);
+    bus.deliver(fleet);
+    fleet.tick(0.1f);
+    wp = fleet.position(worker);
+    cout<<"worker woken by message at ("<<wp[0]<<", "<<wp[1]<<", "<<wp[2]<<")"<<endl;
+    
+    // A reader thread keeps using the worker while its talk strategy is swapped
+    // and the old ones are reclaimed behind it.
+    EpochDomain epochs;
+    atomic<bool> stop{false};
+    atomic<long long> reads{0};
+    thread reader([&]{
+        while(!stop){
+            EpochGuard guard(&epochs);
+            for(int i = 0; i < 1000; i++){
+                reads += rb2->talker()->enabled();
+            }
+        }
+    });
+    rb2->setTalkable(new NormalTalk());
+    while(reads == 0){
+        this_thread::yield();
+    }
+    for(int i = 0; i < 1000; i++){
+        rb2->setTalkable(i % 2 ? (Talkable*)new NormalTalk() : new NoTalk(), &epochs);
+        epochs.reclaim();
+        this_thread::yield();
+    }
+    stop = true;
+    reader.join();
+    epochs.reclaim();
+    cout<<"hot-swapped talk 1000 times under "<<reads<<" reads, "<<epochs.pending()<<" retired strategies left"<<endl;
+    
+    // Walk strategies owned by the worker are swapped and reclaimed while the
+    // fleet keeps ticking; the archetypes never hold on to them.
+    fleet.protect(&epochs);
+    for(int i = 0; i < 100; i++){
+        fleet.swapWalkable(worker, i % 2 ? (Walkable*)new NormalWalk() : new NoWalk(), &epochs);
+        fleet.tick(0.1f);
+        epochs.reclaim();
+    }
+    wp = fleet.position(worker);
+    cout<<"worker after 100 walk swaps at ("<<wp[0]<<", "<<wp[1]<<", "<<wp[2]<<"), "<<epochs.pending()<<" retired strategies left"<<endl;
+    
+    // A strategy type the fleet has no shared instance of still runs: its
+    // rows are stepped with the robot's own strategy.
+    CountingWalk* counting = new CountingWalk();
+    fleet.swapWalkable(worker, counting, &epochs);
+    fleet.setVelocity(worker, 1.0f, 0, 0);
+    for(int i = 0; i < 10; i++){
+        fleet.tick(0.1f);
+    }
+    array<float,3> cp = fleet.position(worker);
+    cout<<"custom walk stepped "<<counting->steps<<" times, worker at ("<<cp[0]<<", "<<cp[1]<<", "<<cp[2]<<")"<<endl;
+    
+    // Readers hand their slots back when they exit, and more concurrent
+    // readers than slots still read safely, only reclaim() waits for them.
+    EpochDomain other;
+    atomic<int> inside{0};
+    atomic<bool> release{false};
+    vector<thread> readers;
+    for(int i = 0; i < 80; i++){
+        readers.emplace_back([&]{
+            EpochGuard a(&epochs);
+            EpochGuard b(&other);
+            inside++;
+            while(!release) this_thread::yield();
+        });
+    }
+    while(inside < 80) this_thread::yield();
+    rb2->setTalkable(new NoTalk(), &epochs);
+    size_t freedInside = epochs.reclaim();
+    release = true;
+    for(auto& th:readers) th.join();
+    size_t freedAfter = epochs.reclaim();
+    for(int i = 0; i < 200; i++){
+        thread([&]{ EpochGuard guard(&epochs); reads += rb2->talker()->enabled(); }).join();
+    }
+    cout<<"80 concurrent readers : freed "<<freedInside<<" while reading, "<<freedAfter<<" after; 200 short-lived readers ok"<<endl;
 
    
 	return 0;
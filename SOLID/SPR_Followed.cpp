@@ -7,26 +7,251 @@
  * 2. ShippingCart - Manages cart operations only
  * 3. InvoicePrinter - Handles invoice printing (UI responsibility)
  * 4. dbConnection - Handles database operations (Data persistence responsibility)
+ * 5. ProductCatalog - Stores the shared product entries (Lookup responsibility)
+ * 6. InvoiceArchive - Keeps every printed invoice (Archival responsibility)
  * 
  * This follows SRP because each class has only one reason to change.
  * If we need to change how invoices are printed, we only modify InvoicePrinter.
  * If we need to change database operations, we only modify dbConnection.
+ * 
+ * Build: g++ -std=c++17 -O2 -pthread SPR_Followed.cpp -lz
  */
 
 #include<bits/stdc++.h>
+#include <zlib.h>
+#include "../Instrumentation/Metrics.h"
 
 using namespace std;
 
 // Product class - Single responsibility: Represent product data
+// The price is atomic so a catalog price update is seen by every cart
+// without stopping the threads that read it.
 class Product{
     public:
+    uint32_t id = 0;        // catalog id, 0 for a product outside the catalog
+    string sku;
     string name;
-    double price;
+    atomic<double> price;
 
     Product(string name,double price){
         this->name =  name;
         this->price = price;
     }
+
+    Product(uint32_t id,string sku,string name,double price){
+        this->id = id;
+        this->sku = sku;
+        this->name = name;
+        this->price = price;
+    }
+
+    double getPrice() const {
+        return price.load(memory_order_relaxed);
+    }
+};
+
+/*
+ * ✅ FOLLOWING SRP: ProductCatalog class has SINGLE responsibility
+ * 
+ * Responsibility: Owning the one shared copy of every product
+ * - Looking products up by SKU or by id
+ * - Adding products and updating prices
+ * - Bulk loading the catalog from a flat file
+ * 
+ * Carts hold pointers to catalog entries instead of their own Product
+ * objects, so a name is stored once no matter how many carts contain it.
+ * 
+ * Concurrency:
+ * - SKUs are spread over SHARDS shards by hash, each with its own write lock,
+ *   so writers to different shards never wait for each other
+ * - Each shard is an open-addressing table published through an atomic
+ *   pointer; readers probe it without any lock
+ * - Writers fill empty slots in place (release store); when a table is half
+ *   full the writer builds a table twice the size and publishes it, readers
+ *   of the old table still see every entry it had
+ * - Old tables are kept until the catalog is destroyed (at most as much
+ *   memory again as the live tables, since sizes double)
+ */
+class ProductCatalog{
+    private:
+    static const int SHARDS = 64;
+    static const size_t ID_CHUNK = 4096;
+    static const size_t MAX_ID_CHUNKS = 4096;
+
+    struct Table{
+        size_t mask;
+        size_t used = 0;
+        unique_ptr<atomic<Product*>[]> slots;
+
+        Table(size_t capacity) : mask(capacity - 1), slots(new atomic<Product*>[capacity]()) {}
+    };
+
+    struct alignas(64) Shard{
+        mutex writeLock;
+        atomic<Table*> table{nullptr};
+        vector<unique_ptr<Table>> tables;
+    };
+
+    Shard shards[SHARDS];
+    unique_ptr<atomic<atomic<Product*>*>[]> byId;
+    atomic<uint32_t> nextId{1};
+
+    static uint64_t hashOf(const string& sku){
+        uint64_t h = 1469598103934665603ULL;
+        for(unsigned char c : sku){
+            h = (h ^ c) * 1099511628211ULL;
+        }
+        return h;
+    }
+
+    static Product* probe(const Table* table, uint64_t hash, const string& sku){
+        for(size_t i = (hash >> 6) & table->mask; ; i = (i + 1) & table->mask){
+            Product* p = table->slots[i].load(memory_order_acquire);
+            if(p == nullptr || p->sku == sku) return p;
+        }
+    }
+
+    static void place(Table* table, Product* product){
+        size_t i = (hashOf(product->sku) >> 6) & table->mask;
+        while(table->slots[i].load(memory_order_relaxed) != nullptr){
+            i = (i + 1) & table->mask;
+        }
+        table->slots[i].store(product, memory_order_release);
+        table->used++;
+    }
+
+    // Writers only: allocates the id's chunk on first use.
+    atomic<Product*>& idSlot(uint32_t id){
+        atomic<atomic<Product*>*>& chunk = byId[id / ID_CHUNK];
+        atomic<Product*>* current = chunk.load(memory_order_acquire);
+        if(current == nullptr){
+            atomic<Product*>* fresh = new atomic<Product*>[ID_CHUNK]();
+            if(chunk.compare_exchange_strong(current, fresh, memory_order_acq_rel)){
+                current = fresh;
+            }else{
+                delete[] fresh;
+            }
+        }
+        return current[id % ID_CHUNK];
+    }
+
+    public:
+    ProductCatalog() : byId(new atomic<atomic<Product*>*>[MAX_ID_CHUNKS]()) {}
+
+    ~ProductCatalog(){
+        for(size_t c = 0; c < MAX_ID_CHUNKS; c++){
+            atomic<Product*>* chunk = byId[c].load(memory_order_relaxed);
+            if(chunk == nullptr) continue;
+            for(size_t i = 0; i < ID_CHUNK; i++){
+                delete chunk[i].load(memory_order_relaxed);
+            }
+            delete[] chunk;
+        }
+    }
+
+    ProductCatalog(const ProductCatalog&) = delete;
+    ProductCatalog& operator=(const ProductCatalog&) = delete;
+
+    // Adds a product and returns its id; an existing SKU keeps its entry
+    // and id. Returns 0 if the catalog is full.
+    uint32_t add(const string& sku, const string& name, double price){
+        uint64_t hash = hashOf(sku);
+        Shard& shard = shards[hash % SHARDS];
+        lock_guard<mutex> guard(shard.writeLock);
+        Table* table = shard.table.load(memory_order_relaxed);
+        if(table){
+            if(Product* existing = probe(table, hash, sku)) return existing->id;
+        }
+        // A full catalog must not consume the id, or get() would accept it
+        uint32_t id = nextId.load(memory_order_relaxed);
+        do{
+            if(id >= ID_CHUNK * MAX_ID_CHUNKS) return 0;
+        }while(!nextId.compare_exchange_weak(id, id + 1, memory_order_relaxed));
+        Product* product = new Product(id, sku, name, price);
+        idSlot(id).store(product, memory_order_release);
+
+        if(table == nullptr || (table->used + 1) * 2 > table->mask + 1){
+            auto grown = make_unique<Table>(table ? (table->mask + 1) * 2 : 64);
+            if(table){
+                for(size_t i = 0; i <= table->mask; i++){
+                    if(Product* p = table->slots[i].load(memory_order_relaxed)) place(grown.get(), p);
+                }
+            }
+            place(grown.get(), product);
+            shard.table.store(grown.get(), memory_order_release);
+            shard.tables.push_back(move(grown));
+        }else{
+            place(table, product);
+        }
+        return id;
+    }
+
+    // Lock-free lookups; nullptr if not in the catalog.
+    Product* find(const string& sku){
+        uint64_t hash = hashOf(sku);
+        const Table* table = shards[hash % SHARDS].table.load(memory_order_acquire);
+        return table ? probe(table, hash, sku) : nullptr;
+    }
+
+    Product* get(uint32_t id){
+        if(id == 0 || id >= ID_CHUNK * MAX_ID_CHUNKS || id >= nextId.load(memory_order_relaxed)) return nullptr;
+        atomic<Product*>* chunk = byId[id / ID_CHUNK].load(memory_order_acquire);
+        return chunk ? chunk[id % ID_CHUNK].load(memory_order_acquire) : nullptr;
+    }
+
+    // Readers (e.g. calculateTotalBill()) see the new price on their next read.
+    bool setPrice(uint32_t id, double price){
+        Product* p = get(id);
+        if(p == nullptr) return false;
+        p->price.store(price, memory_order_relaxed);
+        return true;
+    }
+
+    size_t size(){
+        return nextId.load(memory_order_relaxed) - 1;
+    }
+
+    // Loads "sku,name,price" lines. The file is split into one slice per
+    // thread at line boundaries and the slices are parsed and inserted in
+    // parallel. Returns the number of lines added, -1 if the file can't be read.
+    // Fewer than one thread loads on one.
+    long long loadFile(const string& path, int threads){
+        threads = max(threads, 1);
+        ifstream in(path, ios::binary);
+        if(!in) return -1;
+        string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+        vector<size_t> cuts = {0};
+        for(int t = 1; t < threads; t++){
+            size_t at = max(cuts.back(), data.size() * t / threads);
+            while(at > 0 && at < data.size() && data[at - 1] != '\n') at++;
+            cuts.push_back(at);
+        }
+        cuts.push_back(data.size());
+
+        atomic<long long> added{0};
+        vector<thread> pool;
+        for(int t = 0; t < threads; t++){
+            pool.emplace_back([&, t]{
+                long long count = 0;
+                size_t pos = cuts[t];
+                while(pos < cuts[t + 1]){
+                    size_t end = data.find('\n', pos);
+                    if(end == string::npos || end > cuts[t + 1]) end = cuts[t + 1];
+                    size_t c1 = data.find(',', pos);
+                    size_t c2 = c1 < end ? data.find(',', c1 + 1) : string::npos;
+                    if(c2 < end){
+                        double price = strtod(data.c_str() + c2 + 1, nullptr);
+                        if(add(data.substr(pos, c1 - pos), data.substr(c1 + 1, c2 - c1 - 1), price)) count++;
+                    }
+                    pos = end + 1;
+                }
+                added += count;
+            });
+        }
+        for(auto& th:pool) th.join();
+        return added;
+    }
 };
 
 /*
@@ -53,8 +278,17 @@ class ShippingCart{
     public:
     // ✅ CORRECT: Adding products to cart (core cart responsibility)
     void addProduct(Product* product){
+        METRIC_COUNT("cart_products_added_total", 1);
         products.push_back(product);
     }
+
+    // ✅ CORRECT: Cart line referencing the shared catalog entry
+    bool addProduct(ProductCatalog* catalog, uint32_t id){
+        Product* product = catalog->get(id);
+        if(product == nullptr) return false;
+        addProduct(product);
+        return true;
+    }
     
     // ✅ CORRECT: Providing access to products (cart responsibility)
     const vector<Product*>& getProducts() { 
@@ -63,14 +297,312 @@ class ShippingCart{
 
     // ✅ CORRECT: Calculating total (related to cart management)
     double calculateTotalBill(){
+        METRIC_TIMER("cart_total_bill_ns");
         double total =0;
         for(auto p:products){
-            total+= p->price;
+            total+= p->getPrice();
         }
         return total;
     }
 };
 
+/*
+ * ✅ FOLLOWING SRP: InvoiceArchive class has SINGLE responsibility
+ * 
+ * Responsibility: Retaining every invoice in compressed segment files
+ * - append() only queues the text, a background thread compresses it, so
+ *   the printing path never waits for compression or disk
+ * - Invoices are packed into blocks of about blockBytes and each block is
+ *   compressed on its own (zlib deflate), so reading one invoice inflates
+ *   one block, not the whole file
+ * - Blocks go into segment files of about segmentBytes; each segment ends
+ *   with an index of (invoice number, block offset, offset in block, length)
+ *   followed by a fixed footer, so readSegment() can find any invoice in a
+ *   closed segment with one seek
+ * 
+ * Segment layout:
+ *   "INVSEG01" | blocks: [u32 raw size][u32 compressed size][bytes]...
+ *   | index: IndexEntry... | footer: [u64 index offset][u64 count]["INVIDX01"]
+ * 
+ * Every step of writing is checked. An invoice only counts as retained once
+ * its block is compressed, written and flushed; after the first failure the
+ * archive stops writing, flush() returns false and error() says why.
+ */
+class InvoiceArchive{
+    private:
+    struct IndexEntry{
+        uint64_t number;
+        uint64_t blockOffset;
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    string dir;
+    size_t blockBytes;
+    size_t segmentBytes;
+
+    // Shared with the printing threads
+    mutex lock;
+    condition_variable wake;
+    condition_variable written;
+    vector<string> pending;
+    uint64_t nextNumber = 0;
+    uint64_t durable = 0;
+    uint64_t flushTarget = 0;
+    bool stopping = false;
+    string failure;                 // set once, by the background thread
+
+    // Owned by the background thread
+    string block;
+    vector<IndexEntry> blockEntries;
+    ofstream segment;
+    uint64_t segmentOffset = 0;
+    uint64_t blockNumber = 0;
+    bool broken = false;
+
+    // Read by fetch(): per segment its path, first invoice and index
+    mutex indexLock;
+    vector<string> segmentPaths;
+    vector<uint64_t> segmentFirst;
+    vector<vector<IndexEntry>> segmentIndex;
+
+    atomic<uint64_t> rawBytes{0};
+    atomic<uint64_t> compressedBytes{0};
+    thread worker;
+
+    // Stops all further writing and wakes anyone waiting in flush().
+    bool fail(string why){
+        broken = true;
+        lock_guard<mutex> guard(lock);
+        if(failure.empty()) failure = why;
+        written.notify_all();
+        return false;
+    }
+
+    bool openSegment(){
+        char name[32];
+        snprintf(name, sizeof(name), "/invoices-%06zu.seg", segmentPaths.size() + 1);
+        string path = dir + name;
+        segment.open(path, ios::binary | ios::trunc);
+        segment.write("INVSEG01", 8);
+        if(!segment) return fail("cannot create segment " + path);
+        segmentOffset = 8;
+        lock_guard<mutex> guard(indexLock);
+        segmentPaths.push_back(path);
+        segmentFirst.push_back(blockNumber);
+        segmentIndex.emplace_back();
+        return true;
+    }
+
+    bool closeSegment(){
+        if(!segment.is_open()) return true;
+        vector<IndexEntry> index;
+        {
+            lock_guard<mutex> guard(indexLock);
+            index = segmentIndex.back();
+        }
+        uint64_t indexOffset = segmentOffset;
+        uint64_t count = index.size();
+        segment.write((const char*)index.data(), index.size() * sizeof(IndexEntry));
+        segment.write((const char*)&indexOffset, 8);
+        segment.write((const char*)&count, 8);
+        segment.write("INVIDX01", 8);
+        segment.close();
+        if(!segment) return fail("cannot write the index of " + segmentPaths.back());
+        return true;
+    }
+
+    bool writeBlock(){
+        if(broken) return false;
+        if(block.empty()) return true;
+        if(!segment.is_open() && !openSegment()) return false;
+        uLongf size = compressBound(block.size());
+        string packed(size, '\0');
+        if(compress2((Bytef*)&packed[0], &size, (const Bytef*)block.data(), block.size(), Z_DEFAULT_COMPRESSION) != Z_OK){
+            return fail("cannot compress block");
+        }
+        uint32_t header[2] = {(uint32_t)block.size(), (uint32_t)size};
+        segment.write((const char*)header, sizeof(header));
+        segment.write(packed.data(), size);
+        segment.flush();
+        if(!segment) return fail("cannot write " + segmentPaths.back());
+        rawBytes += block.size();
+        compressedBytes += sizeof(header) + size;
+
+        for(IndexEntry& e : blockEntries) e.blockOffset = segmentOffset;
+        segmentOffset += sizeof(header) + size;
+        {
+            lock_guard<mutex> guard(indexLock);
+            segmentIndex.back().insert(segmentIndex.back().end(), blockEntries.begin(), blockEntries.end());
+        }
+        blockNumber += blockEntries.size();
+        block.clear();
+        blockEntries.clear();
+        {
+            lock_guard<mutex> guard(lock);
+            durable = blockNumber;
+            written.notify_all();
+        }
+        if(segmentOffset >= segmentBytes) return closeSegment();
+        return true;
+    }
+
+    void run(){
+        vector<string> batch;
+        while(true){
+            uint64_t target;
+            {
+                unique_lock<mutex> guard(lock);
+                wake.wait(guard, [&]{ return !pending.empty() || stopping || (flushTarget > durable && failure.empty()); });
+                if(pending.empty() && stopping) break;
+                batch.swap(pending);
+                target = flushTarget;
+            }
+            for(string& invoice : batch){
+                blockEntries.push_back({blockNumber + blockEntries.size(), 0, (uint32_t)block.size(), (uint32_t)invoice.size()});
+                block += invoice;
+                if(block.size() >= blockBytes) writeBlock();
+            }
+            batch.clear();
+            // A flush() is waiting for invoices still in the partial block
+            if(target > blockNumber) writeBlock();
+        }
+        if(writeBlock()) closeSegment();
+        else segment.close();
+    }
+
+    // Sizes come from the file, so they are checked against it before
+    // anything is allocated. Deflate expands at most about 1032:1.
+    static bool readBlock(const string& path, const IndexEntry& e, string& invoice){
+        ifstream in(path, ios::binary | ios::ate);
+        if(!in) return false;
+        uint64_t fileSize = in.tellg();
+        uint32_t header[2];
+        if(e.blockOffset + sizeof(header) > fileSize) return false;
+        if(!in.seekg(e.blockOffset) || !in.read((char*)header, sizeof(header))) return false;
+        if(header[1] > fileSize - e.blockOffset - sizeof(header) || header[0] > (uint64_t)header[1] * 1032 + 64) return false;
+        if((uint64_t)e.offset + e.length > header[0]) return false;
+        string packed(header[1], '\0');
+        if(!in.read(&packed[0], header[1])) return false;
+        string raw(header[0], '\0');
+        uLongf size = header[0];
+        if(uncompress((Bytef*)&raw[0], &size, (const Bytef*)packed.data(), packed.size()) != Z_OK) return false;
+        if(e.offset + e.length > size) return false;
+        invoice = raw.substr(e.offset, e.length);
+        return true;
+    }
+
+    public:
+    InvoiceArchive(string dir, size_t blockBytes = 64 << 10, size_t segmentBytes = 64 << 20){
+        this->dir = dir;
+        this->blockBytes = blockBytes;
+        this->segmentBytes = segmentBytes;
+        error_code ec;
+        filesystem::create_directories(dir, ec);
+        if(ec) fail("cannot create " + dir + ": " + ec.message());
+        worker = thread([this]{ run(); });
+    }
+
+    ~InvoiceArchive(){
+        close();
+    }
+
+    // Queues an invoice and returns its number; never waits for disk.
+    uint64_t append(string invoice){
+        lock_guard<mutex> guard(lock);
+        pending.push_back(move(invoice));
+        if(pending.size() == 1) wake.notify_one();
+        return nextNumber++;
+    }
+
+    // Waits until every invoice appended so far is in a segment file.
+    // false if the archive failed first; see error().
+    bool flush(){
+        unique_lock<mutex> guard(lock);
+        uint64_t target = nextNumber;
+        if(!stopping){
+            flushTarget = target;
+            wake.notify_one();
+        }
+        written.wait(guard, [&]{ return durable >= target || !failure.empty(); });
+        return durable >= target;
+    }
+
+    // Why the archive stopped writing, empty while it is healthy.
+    string error(){
+        lock_guard<mutex> guard(lock);
+        return failure;
+    }
+
+    // Reads back one invoice by number, inflating only its block. Only an
+    // invoice still in the open block waits for a flush.
+    bool fetch(uint64_t number, string& invoice){
+        bool open;
+        {
+            lock_guard<mutex> guard(lock);
+            if(number >= nextNumber) return false;
+            open = number >= durable;
+        }
+        if(open && !flush()) return false;
+        string path;
+        IndexEntry entry;
+        {
+            lock_guard<mutex> guard(indexLock);
+            size_t s = upper_bound(segmentFirst.begin(), segmentFirst.end(), number) - segmentFirst.begin() - 1;
+            path = segmentPaths[s];
+            entry = segmentIndex[s][number - segmentFirst[s]];
+        }
+        return readBlock(path, entry, invoice);
+    }
+
+    // Writes out everything still queued, finishes the last segment and
+    // stops the background thread.
+    void close(){
+        {
+            lock_guard<mutex> guard(lock);
+            if(stopping) return;
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    // Reads one invoice from a closed segment file using its index footer.
+    static bool readSegment(const string& path, uint64_t number, string& invoice){
+        ifstream in(path, ios::binary | ios::ate);
+        if(!in || in.tellg() < 32) return false;
+        uint64_t fileSize = in.tellg();
+        uint64_t footer[2];
+        char magic[8];
+        in.seekg(-24, ios::end);
+        in.read((char*)footer, 16);
+        in.read(magic, 8);
+        if(!in || memcmp(magic, "INVIDX01", 8) != 0) return false;
+        // The index must fill exactly the bytes between the blocks and the footer
+        if(footer[0] < 8 || footer[0] > fileSize - 24 || footer[1] != (fileSize - 24 - footer[0]) / sizeof(IndexEntry)
+            || (fileSize - 24 - footer[0]) % sizeof(IndexEntry) != 0) return false;
+        vector<IndexEntry> index(footer[1]);
+        in.seekg(footer[0]);
+        if(!in.read((char*)index.data(), index.size() * sizeof(IndexEntry))) return false;
+        auto it = lower_bound(index.begin(), index.end(), number, [](const IndexEntry& e, uint64_t n){ return e.number < n; });
+        if(it == index.end() || it->number != number) return false;
+        return readBlock(path, *it, invoice);
+    }
+
+    vector<string> segments(){
+        lock_guard<mutex> guard(indexLock);
+        return segmentPaths;
+    }
+
+    uint64_t bytesIn(){
+        return rawBytes.load();
+    }
+
+    uint64_t bytesOut(){
+        return compressedBytes.load();
+    }
+};
+
 /*
  * ✅ FOLLOWING SRP: InvoicePrinter class has SINGLE responsibility
  * 
@@ -82,19 +614,30 @@ class ShippingCart{
 class InvoicePrinter{
     private:
     ShippingCart* cart;
+    InvoiceArchive* archive;
 
     public:
-    InvoicePrinter(ShippingCart* cart){
+    InvoicePrinter(ShippingCart* cart, InvoiceArchive* archive = nullptr){
         this->cart =  cart;
+        this->archive = archive;
     }
 
     // ✅ CORRECT: Printing invoice is this class's only responsibility
+    // (keeping a copy is delegated to the archive)
     void printInvoice(){
-        cout<<"Invoice"<<endl;
+        METRIC_COUNT("invoices_printed_total", 1);
+        METRIC_TIMER("invoice_print_ns");
+        ostringstream out;
+        out<<"Invoice"<<endl;
         for(auto p:cart->getProducts()){
-            cout<<p->name<<" : "<<p->price<<endl;
+            out<<p->name<<" : "<<p->getPrice()<<endl;
+        }
+        out<<"Total Bill : "<<cart->calculateTotalBill()<<endl;
+        string invoice = out.str();
+        cout<<invoice;
+        if(archive){
+            archive->append(move(invoice));
         }
-        cout<<"Total Bill : "<<cart->calculateTotalBill()<<endl;
     }
 };
 
@@ -124,7 +667,140 @@ class dbConnection{
 
 
 
-int main(){
+// Bulk-loads a generated catalog file with 1 and 4 threads, then runs
+// lock-free lookups on several threads while another thread keeps
+// changing prices.
+void catalogBenchmark(size_t products){
+    const string path = "catalog_bench.csv";
+    {
+        ofstream out(path);
+        for(size_t i = 1; i <= products; i++){
+            out<<"SKU-"<<i<<",Product "<<i<<","<<(i % 500) + 0.99<<"\n";
+        }
+    }
+
+    for(int threads : {1, 4}){
+        ProductCatalog catalog;
+        auto start = chrono::steady_clock::now();
+        long long loaded = catalog.loadFile(path, threads);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout<<"loadFile("<<threads<<" threads): "<<loaded<<" products in "<<fixed<<setprecision(0)<<ms<<"ms"<<endl;
+    }
+
+    ProductCatalog catalog;
+    catalog.loadFile(path, 4);
+    remove(path.c_str());
+
+    ShippingCart cart;
+    cart.addProduct(&catalog, 1);
+    cart.addProduct(&catalog, 2);
+    double before = cart.calculateTotalBill();
+
+    atomic<bool> stop{false};
+    atomic<uint64_t> lookups{0};
+    uint64_t updates = 0;
+    vector<thread> readers;
+    for(int t = 0; t < 3; t++){
+        readers.emplace_back([&, t]{
+            mt19937 rng(t);
+            uint64_t found = 0;
+            while(!stop.load(memory_order_relaxed)){
+                for(int i = 0; i < 1000; i++){
+                    found += catalog.find("SKU-" + to_string(1 + rng() % products)) != nullptr;
+                }
+            }
+            lookups += found;
+        });
+    }
+    thread writer([&]{
+        while(!stop.load(memory_order_relaxed)){
+            catalog.setPrice(1 + updates % products, 9.99);
+            updates++;
+        }
+    });
+    this_thread::sleep_for(chrono::seconds(1));
+    stop = true;
+    for(auto& th:readers) th.join();
+    writer.join();
+
+    catalog.setPrice(1, 1000);
+    cout<<"1s with 3 readers and 1 price writer: "<<lookups.load()<<" lookups, "<<updates<<" price updates"<<endl;
+    cout<<"cart total before/after price change: "<<setprecision(2)<<before<<" / "<<cart.calculateTotalBill()<<endl;
+}
+
+// Prints invoices with and without an archive attached and compares the
+// printing latency, then reports the compression ratio and the cost of
+// fetching random invoices back.
+void archiveBenchmark(size_t invoices){
+    ProductCatalog catalog;
+    vector<uint32_t> ids;
+    for(int i = 1; i <= 200; i++){
+        ids.push_back(catalog.add("SKU-" + to_string(i), "Product " + to_string(i), 5 + i % 40));
+    }
+    mt19937 rng(1);
+    vector<unique_ptr<ShippingCart>> carts;
+    for(int c = 0; c < 256; c++){
+        carts.emplace_back(new ShippingCart());
+        int lines = 1 + rng() % 8;
+        for(int l = 0; l < lines; l++) carts.back()->addProduct(&catalog, ids[rng() % ids.size()]);
+    }
+
+    ostringstream sink;
+    streambuf* console = cout.rdbuf(sink.rdbuf());
+    metrics::Histogram plain, archived;
+    for(size_t i = 0; i < invoices; i++){
+        InvoicePrinter printer(carts[i % carts.size()].get());
+        metrics::ScopedTimer timer(plain);
+        printer.printInvoice();
+        if(sink.tellp() > (1 << 20)) sink.str("");
+    }
+    InvoiceArchive archive("invoice_archive", 64 << 10, 1 << 20);
+    for(size_t i = 0; i < invoices; i++){
+        InvoicePrinter printer(carts[i % carts.size()].get(), &archive);
+        metrics::ScopedTimer timer(archived);
+        printer.printInvoice();
+        if(sink.tellp() > (1 << 20)) sink.str("");
+    }
+    cout.rdbuf(console);
+    archive.flush();
+
+    auto start = chrono::steady_clock::now();
+    string invoice;
+    int ok = 0;
+    for(int i = 0; i < 1000; i++){
+        ok += archive.fetch(rng() % invoices, invoice);
+    }
+    double fetchMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / 1000;
+    archive.close();
+    string first = archive.segments().front();
+    bool cold = InvoiceArchive::readSegment(first, 0, invoice);
+
+    metrics::HistogramSnapshot a = plain.snapshot(), b = archived.snapshot();
+    cout<<invoices<<" invoices, print p50/p99 ns without archive: "<<a.percentile(0.5)<<" / "<<a.percentile(0.99)
+        <<", with archive: "<<b.percentile(0.5)<<" / "<<b.percentile(0.99)<<endl;
+    cout<<"archived "<<archive.bytesIn()<<" bytes into "<<archive.bytesOut()<<" bytes in "<<archive.segments().size()
+        <<" segments ("<<fixed<<setprecision(1)<<(double)archive.bytesIn() / archive.bytesOut()<<"x)"<<endl;
+    cout<<"random fetch: "<<ok<<"/1000 ok, "<<setprecision(1)<<fetchMicros<<"us each; cold read from "<<first<<": "<<(cold ? "ok" : "failed")<<endl;
+    filesystem::remove_all("invoice_archive");
+
+    // An archive that cannot write reports it instead of claiming the invoice
+    InvoiceArchive broken("/dev/null/invoice_archive");
+    uint64_t lost = broken.append("invoice that cannot be stored");
+    bool stored = broken.flush();
+    cout<<"unwritable archive: flush "<<(stored ? "ok" : "failed")<<", fetch "<<(broken.fetch(lost, invoice) ? "ok" : "failed")
+        <<" ("<<broken.error()<<")"<<endl;
+}
+
+int main(int argc, char* argv[]){
+    if(argc > 1 && string(argv[1]) == "--catalog-bench"){
+        catalogBenchmark(argc > 2 ? stoul(argv[2]) : 1000000);
+        return 0;
+    }
+    if(argc > 1 && string(argv[1]) == "--archive-bench"){
+        archiveBenchmark(argc > 2 ? stoul(argv[2]) : 500000);
+        return 0;
+    }
+
     // Demonstration of SRP being followed
     cout << "=== SRP FOLLOWED EXAMPLE ===" << endl;
     
@@ -143,10 +819,21 @@ int main(){
     printer->printInvoice();    // ✅ UI work handled by InvoicePrinter
     dbConn->DBConnection();     // ✅ Database work handled by dbConnection
 
+    // Cart lines pointing at shared catalog entries (catalog's responsibility)
+    ProductCatalog* catalog = new ProductCatalog();
+    uint32_t keyboard = catalog->add("SKU-KB", "Keyboard", 50);
+    uint32_t mouse = catalog->add("SKU-MS", "Mouse", 20);
+    ShippingCart* catalogCart = new ShippingCart();
+    catalogCart->addProduct(catalog, keyboard);
+    catalogCart->addProduct(catalog, mouse);
+    catalog->setPrice(mouse, 15);              // visible to every cart at once
+    InvoicePrinter(catalogCart).printInvoice();
+
     cout << "\nNote: This design follows SRP - each class has a single responsibility!" << endl;
     cout << "- ShippingCart: Manages cart operations" << endl;
     cout << "- InvoicePrinter: Handles invoice printing" << endl;
     cout << "- dbConnection: Handles database operations" << endl;
+    cout << "- ProductCatalog: Stores shared product entries" << endl;
 
     return 0;
 }
\ No newline at end of file
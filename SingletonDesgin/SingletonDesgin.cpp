@@ -2,30 +2,488 @@
 #define ll long long int 
 using namespace std;
 
+// Lazy, thread-safe singleton for any type T.
+// The function-local static is constructed on first use, exactly once, even
+// when several threads race to it (guaranteed since C++11). Once it is built,
+// every call is one load of the guard flag and a branch: no lock and no
+// atomic read-modify-write on the hot path. Nothing runs at static-init time,
+// so there is no init-order hazard, and the object is destroyed at exit.
+template<class T>
+class LazySingleton{
+    public:
+    static T& instance(){
+        static T object;
+        return object;
+    }
+};
 
 class Singleton{
     private:
-    static Singleton* instance ;
-    
+    friend class LazySingleton<Singleton>;
+
     Singleton(){
         cout<<"Object created "<<endl;
     }
-    
+
     public:
+    Singleton(const Singleton&) = delete;
+    Singleton& operator=(const Singleton&) = delete;
+
     static Singleton* getInstace(){
-        return instance;
+        return &LazySingleton<Singleton>::instance();
+    }
+};
+
+// Sharded singleton for state that many threads update, like counters or
+// small caches. One global instance would put every update on the same cache
+// line; here each thread gets its own cache-line-padded shard and only reads
+// pay to combine them. T must be default constructible and copyable, and
+// provide merge(const T&), which folds another shard into this one and must be
+// safe to call while the owner keeps updating (e.g. relaxed atomic loads).
+template<class T, int Shards = 64>
+class ShardedSingleton{
+    private:
+    struct alignas(64) Shard{
+        T value;
+    };
+
+    static Shard* shards(){
+        static Shard all[Shards];
+        return all;
+    }
+
+    static int shardIndex(){
+        // Threads are handed shards round robin on first use, so up to
+        // Shards threads never share one
+        static atomic<int> next{0};
+        thread_local int index = next.fetch_add(1, memory_order_relaxed) % Shards;
+        return index;
+    }
+
+    public:
+    // This thread's shard: the hot path, never shared with another thread
+    // unless more than Shards threads use the singleton.
+    static T& local(){
+        return shards()[shardIndex()].value;
+    }
+
+    // Merged view of every shard, built on each call.
+    static T aggregate(){
+        T total;
+        Shard* all = shards();
+        for(int i = 0; i < Shards; i++){
+            total.merge(all[i].value);
+        }
+        return total;
+    }
+};
+
+// Registry of named singletons with declared dependencies. Nothing is built
+// when a service is added; get() builds it on first use after its
+// dependencies, and startAll() can instead build everything up front on a
+// thread pool, each service as soon as its dependencies are ready. Services
+// are destroyed in the reverse of the order they were built. A dependency
+// must be added before the services that use it, so there are no cycles.
+class SingletonRegistry{
+    private:
+    struct Entry{
+        string name;
+        vector<int> deps;
+        function<void*(SingletonRegistry&)> make;
+        void (*destroy)(void*);
+        void* object = nullptr;
+        once_flag built;
+        double initMicros = 0;
+    };
+
+    deque<Entry> entries;
+    unordered_map<string, int> index;
+    vector<int> buildOrder;
+    mutex orderLock;
+
+    void ensure(int i){
+        Entry& e = entries[i];
+        call_once(e.built, [&]{
+            for(int d : e.deps){
+                ensure(d);
+            }
+            auto start = chrono::steady_clock::now();
+            e.object = e.make(*this);
+            e.initMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+            lock_guard<mutex> guard(orderLock);
+            buildOrder.push_back(i);
+        });
+    }
+
+    public:
+    SingletonRegistry() {}
+    SingletonRegistry(const SingletonRegistry&) = delete;
+    SingletonRegistry& operator=(const SingletonRegistry&) = delete;
+
+    ~SingletonRegistry(){
+        shutdown();
+    }
+
+    // Registers T under name. T is built with T(SingletonRegistry&) if it has
+    // that constructor, so it can get() its dependencies, else with T().
+    // Returns false if the name is taken or a dependency is not registered.
+    // Not thread-safe: register everything before the first get().
+    template<class T>
+    bool add(const string& name, const vector<string>& deps = {}){
+        if(index.count(name)) return false;
+        vector<int> resolved;
+        for(const string& d : deps){
+            auto it = index.find(d);
+            if(it == index.end()){
+                cout<<"SingletonRegistry: "<<name<<" depends on unknown "<<d<<endl;
+                return false;
+            }
+            resolved.push_back(it->second);
+        }
+        entries.emplace_back();
+        Entry& e = entries.back();
+        e.name = name;
+        e.deps = resolved;
+        e.make = [](SingletonRegistry& registry) -> void* {
+            if constexpr (is_constructible_v<T, SingletonRegistry&>){
+                return new T(registry);
+            }else{
+                (void)registry;
+                return new T();
+            }
+        };
+        e.destroy = [](void* object){ delete static_cast<T*>(object); };
+        index[name] = entries.size() - 1;
+        return true;
+    }
+
+    // Builds name and its dependencies on first use; nullptr for an unknown
+    // name. Safe to call from several threads.
+    template<class T>
+    T* get(const string& name){
+        auto it = index.find(name);
+        if(it == index.end()) return nullptr;
+        ensure(it->second);
+        return static_cast<T*>(entries[it->second].object);
+    }
+
+    // Builds every registered service using the given number of threads,
+    // in dependency order, with independent services built in parallel.
+    void startAll(int threads){
+        int n = entries.size();
+        vector<int> waiting(n);
+        vector<vector<int>> dependents(n);
+        deque<int> ready;
+        for(int i = 0; i < n; i++){
+            waiting[i] = entries[i].deps.size();
+            for(int d : entries[i].deps){
+                dependents[d].push_back(i);
+            }
+            if(waiting[i] == 0) ready.push_back(i);
+        }
+
+        mutex lock;
+        condition_variable wake;
+        int done = 0;
+        auto work = [&]{
+            unique_lock<mutex> guard(lock);
+            while(true){
+                wake.wait(guard, [&]{ return !ready.empty() || done == n; });
+                if(done == n) return;
+                int i = ready.front();
+                ready.pop_front();
+                guard.unlock();
+                ensure(i);
+                guard.lock();
+                done++;
+                for(int next : dependents[i]){
+                    if(--waiting[next] == 0) ready.push_back(next);
+                }
+                wake.notify_all();
+            }
+        };
+
+        vector<thread> pool;
+        for(int t = 0; t < threads; t++){
+            pool.emplace_back(work);
+        }
+        for(auto& th:pool) th.join();
+    }
+
+    // Destroys built services, dependents before their dependencies.
+    void shutdown(){
+        for(int k = (int)buildOrder.size() - 1; k >= 0; k--){
+            Entry& e = entries[buildOrder[k]];
+            e.destroy(e.object);
+            e.object = nullptr;
+        }
+        buildOrder.clear();
+    }
+
+    // Init time of every service built so far, slowest first.
+    void report(){
+        vector<int> built;
+        {
+            lock_guard<mutex> guard(orderLock);
+            built = buildOrder;
+        }
+        sort(built.begin(), built.end(), [&](int a, int b){
+            return entries[a].initMicros > entries[b].initMicros;
+        });
+        cout<<"service        init us"<<endl;
+        for(int i : built){
+            cout<<left<<setw(15)<<entries[i].name<<right<<fixed<<setprecision(0)
+                <<setw(8)<<entries[i].initMicros<<endl;
+        }
+        cout<<entries.size() - built.size()<<" of "<<entries.size()<<" services not built"<<endl;
+    }
+};
+
+// Stand-in for a service whose constructor does real work (parsing config,
+// warming a cache, ...). Each index is a distinct singleton type.
+template<int I>
+struct Service{
+    vector<uint64_t> table;
+
+    Service(){
+        table.resize(1 << 14);
+        uint64_t x = I + 1;
+        for(auto& v:table){
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+            v = x;
+        }
+    }
+};
+
+template<int... I>
+void constructAll(integer_sequence<int, I...>){
+    // What an eager "T* instance = new T()" per service costs before main()
+    (void)initializer_list<int>{(delete new Service<I>(), 0)...};
+}
+
+// Compares start-up cost: eager singletons build every service before main(),
+// lazy ones build only the services a run actually touches, on first use.
+void startupBenchmark(){
+    const int services = 32;
+    auto t0 = chrono::steady_clock::now();
+    constructAll(make_integer_sequence<int, services>());
+    auto t1 = chrono::steady_clock::now();
+
+    LazySingleton<Service<0>>::instance();
+    LazySingleton<Service<7>>::instance();
+    LazySingleton<Service<21>>::instance();
+    LazySingleton<Service<30>>::instance();
+    auto t2 = chrono::steady_clock::now();
+
+    cout<<"startup, eager : "<<services<<" services built before main in "
+        <<chrono::duration<double, micro>(t1 - t0).count()<<"us"<<endl;
+    cout<<"startup, lazy  : 0us before main, 4 used services built on first use in "
+        <<chrono::duration<double, micro>(t2 - t1).count()<<"us"<<endl;
+}
+
+struct Counter{
+    uint64_t value = 1;
+};
+
+// The alternatives the lazy singleton is measured against.
+struct CallOnceCounter{
+    static Counter& instance(){
+        static once_flag flag;
+        static Counter* object;
+        call_once(flag, []{ object = new Counter(); });
+        return *object;
+    }
+};
+
+struct LockedCounter{
+    static Counter& instance(){
+        static mutex lock;
+        static Counter* object = nullptr;
+        lock_guard<mutex> guard(lock);
+        if(object == nullptr){
+            object = new Counter();
+        }
+        return *object;
+    }
+};
+
+template<class Get>
+double nanosPerAccess(int threads, long long perThread, Get get){
+    atomic<uint64_t> sink{0};
+    auto start = chrono::steady_clock::now();
+    vector<thread> pool;
+    for(int t = 0; t < threads; t++){
+        pool.emplace_back([&]{
+            uint64_t sum = 0;
+            for(long long i = 0; i < perThread; i++){
+                // Compiler barrier so the accessor really runs every iteration
+                atomic_signal_fence(memory_order_seq_cst);
+                sum += get().value;
+            }
+            sink += sum;
+        });
+    }
+    for(auto& th:pool) th.join();
+    double nanos = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    return nanos / (threads * perThread);
+}
+
+// Multi-threaded access: every thread hammers instance() in a loop.
+void accessBenchmark(){
+    const long long perThread = 5000000;
+    cout<<"threads   lazy ns/op   call_once ns/op   mutex ns/op"<<endl;
+    for(int threads : {1, 2, 4, 8}){
+        double lazy = nanosPerAccess(threads, perThread, []() -> Counter& { return LazySingleton<Counter>::instance(); });
+        double once = nanosPerAccess(threads, perThread, []() -> Counter& { return CallOnceCounter::instance(); });
+        double locked = nanosPerAccess(threads, perThread, []() -> Counter& { return LockedCounter::instance(); });
+        cout<<setw(7)<<threads<<fixed<<setprecision(2)<<setw(13)<<lazy<<setw(18)<<once<<setw(14)<<locked<<endl;
     }
+}
+
+// Services for the registry demo; constructors sleep to stand in for real
+// start-up work (reading files, opening connections).
+struct Config{
+    Config(){ this_thread::sleep_for(chrono::milliseconds(20)); cout<<"Config up"<<endl; }
+    ~Config(){ cout<<"Config down"<<endl; }
 };
 
-//Intialize static members
-Singleton* Singleton::instance = new Singleton();
+struct Logger{
+    Config* config;
+    Logger(SingletonRegistry& registry) : config(registry.get<Config>("Config")) {
+        this_thread::sleep_for(chrono::milliseconds(5));
+        cout<<"Logger up"<<endl;
+    }
+    ~Logger(){ cout<<"Logger down"<<endl; }
+};
+
+struct Database{
+    Logger* logger;
+    Database(SingletonRegistry& registry) : logger(registry.get<Logger>("Logger")) {
+        this_thread::sleep_for(chrono::milliseconds(40));
+        cout<<"Database up"<<endl;
+    }
+    ~Database(){ cout<<"Database down"<<endl; }
+};
+
+struct Cache{
+    Cache(){ this_thread::sleep_for(chrono::milliseconds(30)); cout<<"Cache up"<<endl; }
+    ~Cache(){ cout<<"Cache down"<<endl; }
+};
+
+struct Mailer{
+    Mailer(){ this_thread::sleep_for(chrono::milliseconds(30)); cout<<"Mailer up"<<endl; }
+    ~Mailer(){ cout<<"Mailer down"<<endl; }
+};
+
+void registerServices(SingletonRegistry& registry){
+    registry.add<Config>("Config");
+    registry.add<Logger>("Logger", {"Config"});
+    registry.add<Database>("Database", {"Config", "Logger"});
+    registry.add<Cache>("Cache", {"Config"});
+    registry.add<Mailer>("Mailer", {"Logger"});
+}
 
-int main() 
+// Start-up time of the same service graph built serially and on 4 threads.
+void registryBenchmark(){
+    for(int threads : {1, 4}){
+        ostringstream quiet;
+        streambuf* console = cout.rdbuf(quiet.rdbuf());
+        double ms;
+        {
+            SingletonRegistry registry;
+            registerServices(registry);
+            auto start = chrono::steady_clock::now();
+            registry.startAll(threads);
+            ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        }
+        cout.rdbuf(console);
+        cout<<"startAll("<<threads<<") built 5 services in "<<fixed<<setprecision(1)<<ms<<"ms"<<endl;
+    }
+}
+
+// Example shard: a hit counter. fetch_add stays correct if two threads ever
+// share a shard, and on a shard owned by one thread it never contends.
+struct HitCounter{
+    atomic<uint64_t> hits{0};
+
+    HitCounter() = default;
+    HitCounter(const HitCounter& other) : hits(other.value()) {}
+
+    void add(uint64_t n){
+        hits.fetch_add(n, memory_order_relaxed);
+    }
+
+    uint64_t value() const {
+        return hits.load(memory_order_relaxed);
+    }
+
+    void merge(const HitCounter& other){
+        hits.fetch_add(other.value(), memory_order_relaxed);
+    }
+};
+
+// Every thread increments the same logical counter: one global HitCounter
+// singleton against the sharded one.
+void shardedBenchmark(){
+    const long long perThread = 1000000;
+    cout<<"threads   global ns/op   sharded ns/op   total ok"<<endl;
+    for(int threads : {1, 2, 4, 8, 16, 32, 64}){
+        HitCounter& global = LazySingleton<HitCounter>::instance();
+        uint64_t globalBefore = global.value();
+        uint64_t shardedBefore = ShardedSingleton<HitCounter>::aggregate().value();
+
+        double shared = nanosPerAccess(threads, perThread, [&global]() -> Counter& {
+            global.add(1);
+            return LazySingleton<Counter>::instance();
+        });
+        double sharded = nanosPerAccess(threads, perThread, []() -> Counter& {
+            ShardedSingleton<HitCounter>::local().add(1);
+            return LazySingleton<Counter>::instance();
+        });
+
+        uint64_t expected = threads * perThread;
+        bool ok = global.value() - globalBefore == expected &&
+                  ShardedSingleton<HitCounter>::aggregate().value() - shardedBefore == expected;
+        cout<<setw(7)<<threads<<fixed<<setprecision(2)<<setw(15)<<shared<<setw(16)<<sharded
+            <<setw(11)<<(ok ? "yes" : "no")<<endl;
+    }
+}
+
+int main(int argc, char* argv[])
 {
-    
+    if(argc > 1 && string(argv[1]) == "--bench"){
+        startupBenchmark();
+        accessBenchmark();
+        shardedBenchmark();
+        registryBenchmark();
+        return 0;
+    }
+
+    cout<<"main started, nothing constructed yet"<<endl;
+
     Singleton* obj1 = Singleton::getInstace();
     Singleton* obj2 = Singleton::getInstace();
 
-   
+    cout<<"same instance : "<<(obj1 == obj2 ? "yes" : "no")<<endl;
+
+    vector<thread> workers;
+    for(int t = 0; t < 4; t++){
+        workers.emplace_back([]{
+            for(int i = 0; i < 1000; i++){
+                ShardedSingleton<HitCounter>::local().add(1);
+            }
+        });
+    }
+    for(auto& th:workers) th.join();
+    cout<<"sharded hits from 4 threads : "<<ShardedSingleton<HitCounter>::aggregate().value()<<endl;
+
+    {
+        SingletonRegistry registry;
+        registerServices(registry);
+        cout<<"registry ready, nothing built yet"<<endl;
+        registry.get<Database>("Database");
+        registry.report();
+    }
+
 	return 0;
 }
@@ -1,4 +1,8 @@
 #include <bits/stdc++.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "../Instrumentation/Metrics.h"
 #define ll long long int 
 using namespace std;
 
@@ -7,6 +11,7 @@ class DocumentElement
 {
     public:
     virtual string rendor() =0;
+    virtual ~DocumentElement() {}
 };
 
 class TextElement: public DocumentElement
@@ -23,6 +28,10 @@ class TextElement: public DocumentElement
     string rendor() override{
         return text;
     }
+    
+    const string& getText(){
+        return text;
+    }
 };
 
 class ImgElement : public DocumentElement
@@ -57,25 +66,641 @@ class TabSpaceElement : public DocumentElement
     }
 };
 
+// Immutable vector stored as a 32-way trie. push_back() and set() return a
+// new version that copies only the nodes on the path to the touched index
+// (O(log32 n) nodes) and shares every other node with the old version, so
+// keeping many versions around costs little more than keeping one.
+template<class T>
+class PersistentVector
+{
+    private:
+    static const int BITS = 5;
+    static const size_t WIDTH = 1 << BITS;
+    static const size_t MASK = WIDTH - 1;
+    
+    // Leaves hold values, inner nodes hold children. Never changed once a
+    // version that can reach it has been returned.
+    struct Node{
+        vector<shared_ptr<Node>> children;
+        vector<T> values;
+    };
+    
+    shared_ptr<Node> root;
+    size_t count = 0;
+    int shift = 0;
+    
+    static shared_ptr<Node> pushPath(const shared_ptr<Node>& node, int level, size_t index, const T& value){
+        auto copy = node ? make_shared<Node>(*node) : make_shared<Node>();
+        if(level == 0){
+            copy->values.push_back(value);
+            return copy;
+        }
+        size_t slot = (index >> level) & MASK;
+        if(slot < copy->children.size()){
+            copy->children[slot] = pushPath(copy->children[slot], level - BITS, index, value);
+        }else{
+            copy->children.push_back(pushPath(nullptr, level - BITS, index, value));
+        }
+        return copy;
+    }
+    
+    static shared_ptr<Node> setPath(const shared_ptr<Node>& node, int level, size_t index, const T& value){
+        auto copy = make_shared<Node>(*node);
+        if(level == 0){
+            copy->values[index & MASK] = value;
+        }else{
+            size_t slot = (index >> level) & MASK;
+            copy->children[slot] = setPath(copy->children[slot], level - BITS, index, value);
+        }
+        return copy;
+    }
+    
+    template<class F>
+    static void visit(const Node* node, int level, F& f){
+        if(level == 0){
+            for(const T& v:node->values) f(v);
+            return;
+        }
+        for(const auto& child:node->children) visit(child.get(), level - BITS, f);
+    }
+    
+    public:
+    size_t size() const {
+        return count;
+    }
+    
+    const T& operator[](size_t index) const {
+        const Node* node = root.get();
+        for(int level = shift; level > 0; level -= BITS){
+            node = node->children[(index >> level) & MASK].get();
+        }
+        return node->values[index & MASK];
+    }
+    
+    PersistentVector push_back(const T& value) const {
+        PersistentVector next = *this;
+        if(count == ((size_t)1 << (shift + BITS))){
+            // Root is full: grow one level, old root becomes the first child
+            auto grown = make_shared<Node>();
+            grown->children.push_back(root);
+            next.root = grown;
+            next.shift += BITS;
+        }
+        next.root = pushPath(next.root, next.shift, count, value);
+        next.count++;
+        return next;
+    }
+    
+    PersistentVector set(size_t index, const T& value) const {
+        PersistentVector next = *this;
+        next.root = setPath(root, shift, index, value);
+        return next;
+    }
+    
+    template<class F>
+    void forEach(F f) const {
+        if(root) visit(root.get(), shift, f);
+    }
+};
+
 class Document
 {
     private:
-    vector<DocumentElement*> docElements;
+    typedef PersistentVector<shared_ptr<DocumentElement>> Elements;
+    Elements docElements;
     
     public:
+    // A version of the document; copying one is O(1).
+    typedef Elements Version;
+    
     void addElement(DocumentElement* element){
-        docElements.push_back(element);
+        docElements = docElements.push_back(shared_ptr<DocumentElement>(element));
+    }
+    
+    void replaceElement(size_t index, DocumentElement* element){
+        docElements = docElements.set(index, shared_ptr<DocumentElement>(element));
+    }
+    
+    size_t size(){
+        return docElements.size();
+    }
+    
+    DocumentElement* element(size_t index){
+        return docElements[index].get();
+    }
+    
+    Version snapshot(){
+        return docElements;
+    }
+    
+    void restore(const Version& version){
+        docElements = version;
     }
     
     string rendor(){
         string result;
         
-        for(auto ele:docElements){
+        docElements.forEach([&](const shared_ptr<DocumentElement>& ele){
             result+=ele->rendor();
+        });
+        
+        return result;
+    }
+};
+
+// Where a search query matched: the element index and the byte offset of the
+// match inside that element's text.
+struct SearchHit{
+    size_t element;
+    size_t offset;
+};
+
+// Substring kernels: return the first occurrence of needle[0, m) in
+// [begin, end), or nullptr. The AVX2 one compares the first and last needle
+// byte against 32 positions at once and only memcmps where both match.
+typedef const char* (*FindFn)(const char* begin, const char* end, const char* needle, size_t m);
+
+static const char* findScalar(const char* begin, const char* end, const char* needle, size_t m){
+    string_view hay(begin, end - begin);
+    size_t at = hay.find(string_view(needle, m));
+    return at == string_view::npos ? nullptr : begin + at;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static const char* findAVX2(const char* begin, const char* end, const char* needle, size_t m){
+    size_t n = end - begin;
+    if(m == 0) return begin;
+    if(m > n) return nullptr;
+    if(m == 1) return (const char*)memchr(begin, needle[0], n);
+    __m256i first = _mm256_set1_epi8(needle[0]);
+    __m256i last = _mm256_set1_epi8(needle[m - 1]);
+    size_t i = 0;
+    for(; i + m - 1 + 32 <= n; i += 32){
+        __m256i a = _mm256_loadu_si256((const __m256i*)(begin + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(begin + i + m - 1));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+        while(mask){
+            int bit = __builtin_ctz(mask);
+            if(memcmp(begin + i + bit + 1, needle + 1, m - 2) == 0){
+                return begin + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    for(; i + m <= n; i++){
+        if(begin[i] == needle[0] && memcmp(begin + i + 1, needle + 1, m - 1) == 0){
+            return begin + i;
         }
+    }
+    return nullptr;
+}
+#endif
+
+static FindFn resolveFind(const char** name){
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")){
+        *name = "avx2";
+        return findAVX2;
+    }
+#endif
+    *name = "scalar";
+    return findScalar;
+}
+
+// Picked once on first use.
+static FindFn findKernel(const char** name = nullptr){
+    static const char* kernelName = nullptr;
+    static FindFn fn = resolveFind(&kernelName);
+    if(name) *name = kernelName;
+    return fn;
+}
+
+// Full-text search over the TextElement runs of a Document.
+// scan() checks every run with the SIMD kernel. find() first narrows the runs
+// with a trigram index: every 3-byte sequence maps to the sorted list of
+// elements containing it, and only elements in all of the query's lists are
+// scanned. Trigrams are looked up in a direct-mapped table paged by their
+// first byte, so indexing does no hashing. The index is kept up to date by
+// indexText() as text is added. It may still list elements that an undo has
+// removed or a replace has changed, which is harmless because every candidate
+// is checked against the current document. Matches that span two elements
+// are not found.
+class DocumentSearch
+{
+    private:
+    Document* document;
+    // pages[first byte][last two bytes] = 1 + position in postings, 0 if unseen
+    array<unique_ptr<uint32_t[]>, 256> pages;
+    vector<vector<uint32_t>> postings;
+    
+    static uint32_t trigram(const char* p){
+        return (uint32_t)(unsigned char)p[0] << 16 | (uint32_t)(unsigned char)p[1] << 8 | (unsigned char)p[2];
+    }
+    
+    const vector<uint32_t>* lookup(uint32_t gram){
+        const uint32_t* page = pages[gram >> 16].get();
+        if(page == nullptr || page[gram & 0xFFFF] == 0) return nullptr;
+        return &postings[page[gram & 0xFFFF] - 1];
+    }
+    
+    vector<uint32_t>& listOf(uint32_t gram){
+        unique_ptr<uint32_t[]>& page = pages[gram >> 16];
+        if(!page) page.reset(new uint32_t[1 << 16]());
+        uint32_t& slot = page[gram & 0xFFFF];
+        if(slot == 0){
+            postings.emplace_back();
+            slot = postings.size();
+        }
+        return postings[slot - 1];
+    }
+    
+    void matchElement(size_t index, string_view query, vector<SearchHit>& hits){
+        TextElement* text = dynamic_cast<TextElement*>(document->element(index));
+        if(text == nullptr) return;
+        const string& run = text->getText();
+        const char* begin = run.data();
+        const char* end = begin + run.size();
+        FindFn find = findKernel();
+        for(const char* at = find(begin, end, query.data(), query.size()); at; at = find(at + 1, end, query.data(), query.size())){
+            hits.push_back({index, (size_t)(at - begin)});
+        }
+    }
+    
+    public:
+    DocumentSearch(Document* document){
+        this->document = document;
+        for(size_t i = 0; i < document->size(); i++){
+            if(TextElement* text = dynamic_cast<TextElement*>(document->element(i))){
+                indexText(i, text->getText());
+            }
+        }
+    }
+    
+    // Adds the trigrams of the text stored at element index.
+    void indexText(size_t index, const string& text){
+        for(size_t i = 0; i + 3 <= text.size(); i++){
+            vector<uint32_t>& list = listOf(trigram(text.data() + i));
+            if(list.empty() || list.back() < index){
+                list.push_back(index);
+            }else if(list.back() != index){
+                // A replaced element further back: keep the list sorted
+                auto it = lower_bound(list.begin(), list.end(), (uint32_t)index);
+                if(*it != index) list.insert(it, index);
+            }
+        }
+    }
+    
+    // Ad-hoc query: scans every TextElement.
+    vector<SearchHit> scan(string_view query){
+        vector<SearchHit> hits;
+        if(query.empty()) return hits;
+        for(size_t i = 0; i < document->size(); i++){
+            matchElement(i, query, hits);
+        }
+        return hits;
+    }
+    
+    // Indexed query; falls back to scan() for queries shorter than 3 bytes.
+    vector<SearchHit> find(string_view query){
+        if(query.size() < 3) return scan(query);
+        vector<const vector<uint32_t>*> lists;
+        for(size_t i = 0; i + 3 <= query.size(); i++){
+            const vector<uint32_t>* list = lookup(trigram(query.data() + i));
+            if(list == nullptr) return {};
+            lists.push_back(list);
+        }
+        sort(lists.begin(), lists.end(), [](auto a, auto b){ return a->size() < b->size(); });
+        lists.erase(unique(lists.begin(), lists.end()), lists.end());
         
+        vector<uint32_t> candidates = *lists[0];
+        for(size_t k = 1; k < lists.size() && !candidates.empty(); k++){
+            const vector<uint32_t>& list = *lists[k];
+            candidates.erase(remove_if(candidates.begin(), candidates.end(), [&](uint32_t c){
+                return !binary_search(list.begin(), list.end(), c);
+            }), candidates.end());
+        }
+        
+        vector<SearchHit> hits;
+        for(uint32_t c : candidates){
+            if(c < document->size()) matchElement(c, query, hits);
+        }
+        return hits;
+    }
+    
+    size_t indexedTrigrams(){
+        return postings.size();
+    }
+};
+
+// Identifies one CRDT operation: the writer's Lamport counter and its site
+// id. Site ids are unique across every replica, so ids are unique and
+// totally ordered. A counter of 0 is never issued.
+struct OpId{
+    uint32_t counter = 0;
+    uint32_t replica = 0;
+    
+    uint64_t key() const {
+        return (uint64_t)counter << 32 | replica;
+    }
+    
+    bool valid() const {
+        return counter != 0;
+    }
+    
+    bool operator<(const OpId& other) const {
+        return key() < other.key();
+    }
+};
+
+// INSERT puts element right after ref (ref {0,0} is the start of the
+// document); REMOVE hides the element inserted by ref.
+struct ElementOp{
+    enum Kind : uint8_t { INSERT, REMOVE };
+    Kind kind = INSERT;
+    OpId id;
+    OpId ref;
+    shared_ptr<DocumentElement> element;
+};
+
+// Append-only log with one writer and any number of readers. Ops live in
+// fixed-size chunks that never move, and the writer publishes the new length
+// with a release store, so appending and reading take no lock.
+class OpLog
+{
+    private:
+    static const size_t CHUNK = 4096;
+    static const size_t MAX_CHUNKS = 1 << 14;
+    
+    unique_ptr<atomic<ElementOp*>[]> chunks;
+    atomic<size_t> published{0};
+    
+    public:
+    OpLog() : chunks(new atomic<ElementOp*>[MAX_CHUNKS]()) {}
+    
+    ~OpLog(){
+        for(size_t c = 0; c < MAX_CHUNKS; c++){
+            delete[] chunks[c].load(memory_order_relaxed);
+        }
+    }
+    
+    // Writer thread only.
+    bool append(const ElementOp& op){
+        size_t n = published.load(memory_order_relaxed);
+        if(n / CHUNK == MAX_CHUNKS) return false;
+        ElementOp* chunk = chunks[n / CHUNK].load(memory_order_relaxed);
+        if(chunk == nullptr){
+            chunk = new ElementOp[CHUNK];
+            chunks[n / CHUNK].store(chunk, memory_order_relaxed);
+        }
+        chunk[n % CHUNK] = op;
+        published.store(n + 1, memory_order_release);
+        return true;
+    }
+    
+    size_t size() const {
+        return published.load(memory_order_acquire);
+    }
+    
+    // Calls f on ops [from, size()) and returns the new size.
+    template<class F>
+    size_t readFrom(size_t from, F f) const {
+        size_t end = size();
+        for(size_t i = from; i < end; i++){
+            f(chunks[i / CHUNK].load(memory_order_relaxed)[i % CHUNK]);
+        }
+        return end;
+    }
+};
+
+class CrdtDocument;
+
+// One writer of a CrdtDocument, used by one thread. Its ops only go into its
+// own log; the document sees them at the next merge().
+class CrdtWriter
+{
+    private:
+    friend class CrdtDocument;
+    uint32_t replica;
+    uint32_t clock = 0;
+    OpId last;
+    OpLog log;
+    const atomic<uint32_t>* seen;   // highest counter the document has seen
+    
+    CrdtWriter(uint32_t replica, const atomic<uint32_t>* seen){
+        this->replica = replica;
+        this->seen = seen;
+    }
+    
+    // Lamport rule: the new op is newer than anything merged into the
+    // document so far, so an insert made after seeing another writer's insert
+    // at the same spot sorts before it. The clock only advances once the op
+    // is in the log.
+    OpId publish(ElementOp& op){
+        uint32_t next = max({clock, op.ref.counter, seen->load(memory_order_acquire)}) + 1;
+        op.id = {next, replica};
+        if(!log.append(op)) return OpId();
+        clock = next;
+        return op.id;
+    }
+    
+    public:
+    // Inserts after this writer's previous append, or at the start.
+    OpId append(DocumentElement* element){
+        OpId id = insertAfter(last, element);
+        if(id.valid()) last = id;
+        return id;
+    }
+    
+    // Returns an invalid id, and frees element, when the log is full.
+    OpId insertAfter(OpId ref, DocumentElement* element){
+        ElementOp op;
+        op.kind = ElementOp::INSERT;
+        op.ref = ref;
+        op.element = shared_ptr<DocumentElement>(element);
+        return publish(op);
+    }
+    
+    // false when the log is full and the remove was not recorded.
+    bool remove(OpId target){
+        ElementOp op;
+        op.kind = ElementOp::REMOVE;
+        op.ref = target;
+        return publish(op).valid();
+    }
+    
+    // Everything this writer has published, e.g. to replay on a replica.
+    vector<ElementOp> ops(){
+        vector<ElementOp> all;
+        log.readFrom(0, [&](const ElementOp& op){ all.push_back(op); });
+        return all;
+    }
+    
+    uint32_t id(){
+        return replica;
+    }
+};
+
+// Document mode for several concurrent writers, based on the RGA sequence
+// CRDT. Every element is a node whose parent is the element it was inserted
+// after; siblings are ordered newest id first and the document is the
+// pre-order walk of that tree. Removed elements stay as hidden tombstones.
+// The order depends only on the set of ops applied, not on the order or
+// batching in which they arrive, so every replica that has seen the same ops
+// renders the same document.
+class CrdtDocument
+{
+    private:
+    struct Node{
+        OpId id;
+        shared_ptr<DocumentElement> element;
+        bool removed = false;
+        vector<Node*> children;
+    };
+    
+    Node root;
+    deque<Node> nodes;
+    unordered_map<uint64_t, Node*> byId;
+    vector<ElementOp> pending;
+    size_t visible = 0;
+    atomic<uint32_t> seen{0};
+    
+    deque<unique_ptr<CrdtWriter>> writers;
+    vector<size_t> consumed;
+    mutex mergeLock;
+    
+    Node* find(OpId id){
+        if(id.key() == 0) return &root;
+        auto it = byId.find(id.key());
+        return it == byId.end() ? nullptr : it->second;
+    }
+    
+    // false if the op refers to an element this replica has not seen yet
+    bool applyOne(const ElementOp& op){
+        if(byId.count(op.id.key())) return true;
+        Node* target = find(op.ref);
+        if(target == nullptr) return false;
+        if(op.kind == ElementOp::REMOVE){
+            if(!target->removed && target != &root){
+                target->removed = true;
+                visible--;
+            }
+            // Remember the op id so a replayed remove is ignored
+            byId[op.id.key()] = target;
+            return true;
+        }
+        nodes.push_back({op.id, op.element, false, {}});
+        Node* node = &nodes.back();
+        byId[op.id.key()] = node;
+        auto at = target->children.begin();
+        while(at != target->children.end() && op.id < (*at)->id) at++;
+        target->children.insert(at, node);
+        visible++;
+        return true;
+    }
+    
+    void applyBatch(vector<ElementOp>& batch){
+        sort(batch.begin(), batch.end(), [](const ElementOp& a, const ElementOp& b){ return a.id < b.id; });
+        if(!batch.empty() && batch.back().id.counter > seen.load(memory_order_relaxed)){
+            seen.store(batch.back().id.counter, memory_order_release);
+        }
+        for(const ElementOp& op : batch){
+            if(!applyOne(op)) pending.push_back(op);
+        }
+        // Ops that arrived before what they refer to
+        bool progress = true;
+        while(progress && !pending.empty()){
+            progress = false;
+            vector<ElementOp> retry;
+            retry.swap(pending);
+            for(const ElementOp& op : retry){
+                if(applyOne(op)) progress = true;
+                else pending.push_back(op);
+            }
+        }
+    }
+    
+    template<class F>
+    void forEachVisible(F f){
+        vector<Node*> stack(root.children.rbegin(), root.children.rend());
+        while(!stack.empty()){
+            Node* node = stack.back();
+            stack.pop_back();
+            if(!node->removed) f(node);
+            stack.insert(stack.end(), node->children.rbegin(), node->children.rend());
+        }
+    }
+    
+    public:
+    CrdtDocument() {}
+    CrdtDocument(const CrdtDocument&) = delete;
+    CrdtDocument& operator=(const CrdtDocument&) = delete;
+    
+    // A new writer for site, which must be unique across every replica that
+    // will ever exchange ops (e.g. handed out by the server), or two replicas
+    // would issue the same op ids. nullptr if site is 0 or already writes
+    // here. Hand each thread its own writer.
+    CrdtWriter* writer(uint32_t site){
+        lock_guard<mutex> guard(mergeLock);
+        if(site == 0) return nullptr;
+        for(auto& w : writers){
+            if(w->replica == site) return nullptr;
+        }
+        writers.emplace_back(new CrdtWriter(site, &seen));
+        consumed.push_back(0);
+        return writers.back().get();
+    }
+    
+    // Collects everything writers published since the last merge and applies
+    // it as one batch. Writers keep appending meanwhile. Returns ops merged.
+    size_t merge(){
+        METRIC_TIMER("crdt_merge_ns");
+        lock_guard<mutex> guard(mergeLock);
+        vector<ElementOp> batch;
+        for(size_t w = 0; w < writers.size(); w++){
+            consumed[w] = writers[w]->log.readFrom(consumed[w], [&](const ElementOp& op){ batch.push_back(op); });
+        }
+        size_t merged = batch.size();
+        applyBatch(batch);
+        return merged;
+    }
+    
+    // Applies ops from elsewhere, e.g. another replica's writer logs.
+    void apply(vector<ElementOp> ops){
+        lock_guard<mutex> guard(mergeLock);
+        applyBatch(ops);
+    }
+    
+    size_t size(){
+        lock_guard<mutex> guard(mergeLock);
+        return visible;
+    }
+    
+    // Ops waiting for an element this replica has not seen.
+    size_t waiting(){
+        lock_guard<mutex> guard(mergeLock);
+        return pending.size();
+    }
+    
+    string rendor(){
+        lock_guard<mutex> guard(mergeLock);
+        string result;
+        forEachVisible([&](Node* node){ result += node->element->rendor(); });
         return result;
     }
+    
+    // Hash of the visible elements, ids and content, in order; equal on
+    // converged replicas.
+    uint64_t fingerprint(){
+        lock_guard<mutex> guard(mergeLock);
+        uint64_t h = 1469598103934665603ULL;
+        forEachVisible([&](Node* node){
+            h = (h ^ node->id.key()) * 1099511628211ULL;
+            h = (h ^ hash<string>()(node->element->rendor())) * 1099511628211ULL;
+        });
+        return h;
+    }
 };
 
 class Presistance
@@ -116,31 +741,104 @@ class DocumentEditor
     Presistance* storage;
     string rendorDoc;
     
+    // Versions before (undo) and after (redo) the current one. Versions share
+    // structure, so each step costs O(log n) memory, not a copy of the document.
+    DocumentSearch search;
+    deque<Document::Version> undoHistory;
+    vector<Document::Version> redoHistory;
+    size_t historyDepth;
+    
+    // Called before every edit
+    void remember(){
+        undoHistory.push_back(document->snapshot());
+        if(undoHistory.size() > historyDepth){
+            undoHistory.pop_front();
+        }
+        redoHistory.clear();
+        rendorDoc.clear();
+    }
+    
     public:
     
-    DocumentEditor(Document* document,Presistance* storage){
+    DocumentEditor(Document* document,Presistance* storage,size_t historyDepth = 100) : search(document) {
         this->document =  document;
         this->storage =  storage;
+        this->historyDepth = historyDepth;
     }
     
     
     void addText(string text){
+        METRIC_COUNT("editor_text_added_total", 1);
+        remember();
+        search.indexText(document->size(), text);
         document->addElement(new TextElement(text));
     }
     
     void addImage(string path){
+        METRIC_COUNT("editor_images_added_total", 1);
+        remember();
         document->addElement(new ImgElement(path));
     }
     
     void addNewLine(){
+        METRIC_COUNT("editor_newlines_added_total", 1);
+        remember();
         document->addElement(new NewLineElement());
     }
     
     void addTabSpace(){
+        METRIC_COUNT("editor_tabs_added_total", 1);
+        remember();
         document->addElement(new TabSpaceElement());
     }
     
+    // Replaces the element at index with a text element.
+    bool replaceText(size_t index, string text){
+        if(index >= document->size()){
+            return false;
+        }
+        remember();
+        search.indexText(index, text);
+        document->replaceElement(index, new TextElement(text));
+        return true;
+    }
+    
+    bool undo(){
+        if(undoHistory.empty()){
+            return false;
+        }
+        redoHistory.push_back(document->snapshot());
+        document->restore(undoHistory.back());
+        undoHistory.pop_back();
+        rendorDoc.clear();
+        return true;
+    }
+    
+    bool redo(){
+        if(redoHistory.empty()){
+            return false;
+        }
+        undoHistory.push_back(document->snapshot());
+        document->restore(redoHistory.back());
+        redoHistory.pop_back();
+        rendorDoc.clear();
+        return true;
+    }
+    
+    // Indexed search over the text runs.
+    vector<SearchHit> find(string query){
+        METRIC_TIMER("editor_find_ns");
+        return search.find(query);
+    }
+    
+    // Same results as find() without the index: scans every text run.
+    vector<SearchHit> scan(string query){
+        METRIC_TIMER("editor_scan_ns");
+        return search.scan(query);
+    }
+    
     string rendorDocument(){
+        METRIC_TIMER("editor_render_ns");
         if(rendorDoc.empty()){
             rendorDoc = document->rendor();
         }
@@ -149,13 +847,117 @@ class DocumentEditor
     }
     
     void save(){
-        storage->save(rendorDoc);
+        METRIC_TIMER("editor_save_ns");
+        storage->save(rendorDocument());
     }
 };
 
+// Builds a document of the given size from random words in 4 KB text runs,
+// hides a rare phrase in a few runs, then times ad-hoc scans against
+// indexed queries.
+void searchBenchmark(size_t megabytes){
+    mt19937 rng(7);
+    vector<string> words(4000);
+    for(auto& w:words){
+        int len = 3 + rng() % 8;
+        for(int i = 0; i < len; i++) w += char('a' + rng() % 26);
+    }
+    
+    Document* document = new Document();
+    DocumentEditor editor(document, new DBStorage(), 1);
+    const string rare = "zebra crossing 42";
+    size_t runs = megabytes * 256;
+    auto start = chrono::steady_clock::now();
+    for(size_t r = 0; r < runs; r++){
+        string run;
+        while(run.size() < 4096){
+            run += words[rng() % words.size()];
+            run += ' ';
+        }
+        if(r % (runs / 4 + 1) == 7) run += rare;
+        editor.addText(run);
+        editor.addNewLine();
+    }
+    double buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    
+    const char* kernel;
+    findKernel(&kernel);
+    cout<<megabytes<<" MB in "<<runs<<" text runs, built and indexed in "<<fixed<<setprecision(0)<<buildMs<<"ms, kernel "<<kernel<<endl;
+    cout<<"query                  scan ms    find ms   hits  same"<<endl;
+    for(string query : {rare, words[0], string("qzx")}){
+        auto t0 = chrono::steady_clock::now();
+        vector<SearchHit> scanned = editor.scan(query);
+        auto t1 = chrono::steady_clock::now();
+        vector<SearchHit> found = editor.find(query);
+        auto t2 = chrono::steady_clock::now();
+        bool same = scanned.size() == found.size() && equal(scanned.begin(), scanned.end(), found.begin(),
+            [](const SearchHit& a, const SearchHit& b){ return a.element == b.element && a.offset == b.offset; });
+        cout<<left<<setw(20)<<query<<right<<setprecision(2)<<setw(10)<<chrono::duration<double, milli>(t1 - t0).count()
+            <<setw(11)<<chrono::duration<double, milli>(t2 - t1).count()<<setw(7)<<found.size()<<setw(6)<<(same ? "yes" : "no")<<endl;
+    }
+}
+
+// Writers append to one CrdtDocument from their own threads while a merger
+// thread merges in batches. A second replica then replays every writer's log
+// in a different order and batching and must end up identical.
+void crdtBenchmark(){
+    const size_t perWriter = 50000;
+    cout<<"writers   appends Mops/s   merged Mops/s   converged"<<endl;
+    for(int count : {1, 2, 4, 8, 16, 32}){
+        CrdtDocument doc;
+        vector<CrdtWriter*> writers;
+        for(int w = 0; w < count; w++) writers.push_back(doc.writer(w + 1));
+        
+        atomic<int> running{count};
+        auto start = chrono::steady_clock::now();
+        vector<thread> threads;
+        for(CrdtWriter* writer : writers){
+            threads.emplace_back([writer, &running]{
+                for(size_t i = 0; i < perWriter; i++){
+                    writer->append(new TextElement("w"));
+                }
+                running--;
+            });
+        }
+        size_t merged = 0;
+        thread merger([&]{
+            while(running.load() > 0 || merged < perWriter * count){
+                size_t n = doc.merge();
+                merged += n;
+                if(n == 0) this_thread::yield();
+            }
+        });
+        for(auto& th:threads) th.join();
+        double appendSec = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        merger.join();
+        double mergeSec = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        
+        CrdtDocument replica;
+        for(int w = count - 1; w >= 0; w--){
+            vector<ElementOp> ops = writers[w]->ops();
+            for(size_t i = 0; i < ops.size(); i += 777){
+                replica.apply(vector<ElementOp>(ops.begin() + i, ops.begin() + min(ops.size(), i + 777)));
+            }
+        }
+        bool converged = replica.fingerprint() == doc.fingerprint() && doc.size() == perWriter * count;
+        double total = perWriter * count / 1e6;
+        cout<<setw(7)<<count<<fixed<<setprecision(2)<<setw(17)<<total / appendSec<<setw(16)<<total / mergeSec
+            <<setw(12)<<(converged ? "yes" : "no")<<endl;
+    }
+}
+
 //client element
-int main() 
+int main(int argc, char* argv[]) 
 {
+    if(argc > 1 && string(argv[1]) == "--crdt-bench"){
+        crdtBenchmark();
+        return 0;
+    }
+    if(argc > 1 && string(argv[1]) == "--search-bench"){
+        searchBenchmark(argc > 2 ? stoul(argv[2]) : 64);
+        return 0;
+    }
+    
     Document* document =  new Document();
     Presistance* presistance = new FileStorage();
     
@@ -170,6 +972,70 @@ int main()
     
     cout<<editor->rendorDocument()<<endl;
     editor->save();
+    
+    editor->replaceText(1, "Hello!!! this is my edited doc file");
+    cout<<editor->rendorDocument()<<endl;
+    
+    editor->undo();
+    editor->undo();
+    cout<<"after two undos:"<<endl<<editor->rendorDocument()<<endl;
+    
+    editor->redo();
+    cout<<"after redo:"<<endl<<editor->rendorDocument()<<endl;
+    
+    for(SearchHit hit : editor->find("doc")){
+        cout<<"\"doc\" found in element "<<hit.element<<" at offset "<<hit.offset<<endl;
+    }
+    
+    // Two sessions editing one shared document from their own threads
+    CrdtDocument shared;
+    CrdtWriter& alice = *shared.writer(1);
+    CrdtWriter& bob = *shared.writer(2);
+    thread aliceSession([&]{
+        OpId title = alice.append(new TextElement("Shared notes"));
+        alice.append(new NewLineElement());
+        alice.insertAfter(title, new TextElement(" (draft)"));
+    });
+    thread bobSession([&]{
+        bob.append(new TextElement("bob was here"));
+        bob.append(new NewLineElement());
+    });
+    aliceSession.join();
+    bobSession.join();
+    shared.merge();
+    
+    CrdtDocument replica;
+    replica.apply(bob.ops());
+    replica.apply(alice.ops());
+    cout<<shared.rendor()<<endl;
+    cout<<"replica converged : "<<(replica.fingerprint() == shared.fingerprint() ? "yes" : "no")<<endl;
+    
+    // Two replicas, each with a local writer, exchange their ops
+    CrdtDocument siteA, siteB;
+    CrdtWriter* writerA = siteA.writer(3);
+    CrdtWriter* writerB = siteB.writer(4);
+    OpId fromA = writerA->append(new TextElement("from A "));
+    writerB->append(new TextElement("from B "));
+    siteA.merge();
+    siteB.merge();
+    siteA.apply(writerB->ops());
+    siteB.apply(writerA->ops());
+    bool same = siteA.rendor() == siteB.rendor() && siteA.fingerprint() == siteB.fingerprint();
+    cout<<siteA.rendor()<<endl<<"sites converged : "<<(same ? "yes" : "no")<<endl;
+    
+    // B, whose clock is well ahead, inserts after A's text; A merges that and
+    // then inserts at the same spot. A's insert must come out first.
+    for(int i = 0; i < 4; i++){
+        writerB->append(new TextElement("."));
+    }
+    writerB->insertAfter(fromA, new TextElement("B saw A "));
+    siteB.merge();
+    siteA.apply(writerB->ops());
+    writerA->insertAfter(fromA, new TextElement("A saw B "));
+    siteA.merge();
+    siteB.apply(writerA->ops());
+    bool ordered = siteA.rendor().find("from A A saw B B saw A ") != string::npos && siteA.fingerprint() == siteB.fingerprint();
+    cout<<siteA.rendor()<<endl<<"later insert comes first : "<<(ordered ? "yes" : "no")<<endl;
    
    
 	return 0;